@@ -13,6 +13,7 @@
 #include "vgui_controls/controls.h"
 #include "vgui/ISurface.h"
 #include "IVRenderView.h"
+#include "hal/aim_trace.h" // (torbensko)
 
 // Changes to the code originally sourced from:
 // http://forums.steampowered.com/forums/showthread.php?t=688140
@@ -121,15 +122,14 @@ void CHudCrosshair::Paint( void )
   	if ( !IsCurrentViewAccessAllowed() )
 		return;
 	
-	Vector vecStart, vecStop, vecDirection, vecCrossPos;
-	trace_t tr;
+	Vector vecStart, vecDirection, vecCrossPos;
 	
 	AngleVectors(pPlayer->EyeAngles(), &vecDirection);
 	
 	vecStart= pPlayer->EyePosition();
-	vecStop = vecStart + vecDirection * MAX_TRACE_LENGTH;
 	
-	UTIL_TraceLine( vecStart, vecStop, (MASK_SHOT & ~CONTENTS_WINDOW), pPlayer , COLLISION_GROUP_NONE, &tr );
+	// only traced again once the eye has moved or turned enough (torbensko)
+	const trace_t &tr = UTIL_CachedAimTrace( vecStart, vecDirection, (MASK_SHOT & ~CONTENTS_WINDOW), pPlayer, COLLISION_GROUP_NONE );
 	
 	ScreenTransform(tr.endpos, vecCrossPos);
 
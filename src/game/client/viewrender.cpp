@@ -889,6 +889,7 @@ CViewRender::CViewRender()
 	m_BaseDrawFlags = 0;
 	m_pActiveRenderer = NULL;
 	m_pCurrentlyDrawingEntity = NULL;
+	m_bHeadShakeLatchPending = false;						// (torbensko)
 }
 
 
@@ -1821,10 +1822,11 @@ const char *COM_GetModDirectory();
 //			whatToDraw - 
 //-----------------------------------------------------------------------------
 // This renders the entire 3D view.
-void CViewRender::RenderView( const CViewSetup &view, int nClearFlags, int whatToDraw )
+void CViewRender::RenderView( const CViewSetup &viewIn, int nClearFlags, int whatToDraw )
 {
 	m_UnderWaterOverlayMaterial.Shutdown();					// underwater view will set
 
+	CViewSetup view = viewIn;								// (torbensko)
 	m_CurrentView = view;
 
 	C_BaseAnimating::AutoAllowBoneAccess boneaccess( true, true );
@@ -1884,6 +1886,10 @@ void CViewRender::RenderView( const CViewSetup &view, int nClearFlags, int whatT
 		pRenderContext->TurnOnToneMapping();
 		pRenderContext.SafeRelease();
 
+		// pick up the latest head pose before the main view is set up (torbensko)
+		LateLatchHeadShake( &view );
+		m_CurrentView = view;
+
 		// clear happens here probably
 		SetupMain3DView( view, nClearFlags );
 			 	  
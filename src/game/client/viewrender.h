@@ -498,6 +498,10 @@ private:
 	
 private:													// (torbensko)
 	void			ApplyHeadShake(CViewSetup *view);
+	void			LateLatchHeadShake(CViewSetup *view);
+
+	CViewSetup		m_ViewWithoutHeadShake;
+	bool			m_bHeadShakeLatchPending;
 	
 };
 
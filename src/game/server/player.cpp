@@ -560,6 +560,10 @@ CBasePlayer::CBasePlayer( )
 	m_bLagCompensation = false;
 	m_flLaggedMovementValue = 1.0f;
 	m_StuckLast = 0;
+	m_movementReserve = 0.0f;								// (torbensko)
+	m_leanAmount_p = 0.0f;									// (torbensko)
+	m_queuedLean = 0.0f;									// (torbensko)
+	m_leanQueued = false;									// (torbensko)
 	m_impactEnergyScale = 1.0f;
 	m_fLastPlayerTalkTime = 0.0f;
 	m_PlayerInfo.SetParent( this );
@@ -3518,8 +3522,8 @@ void CBasePlayer::PlayerRunCommand(CUserCmd *ucmd, IMoveHelper *moveHelper)
 		}
 	}
 	
+	FlushQueuedLean();										// (torbensko)
 	PlayerMove()->RunCommand(this, ucmd, moveHelper);
-	PerformLean(ucmd->lean);								// (torbensko)
 }
 
 //-----------------------------------------------------------------------------
@@ -4363,6 +4367,8 @@ void CBasePlayer::PostThink()
 {
 	m_vecSmoothedVelocity = m_vecSmoothedVelocity * SMOOTHING_FACTOR + GetAbsVelocity() * ( 1 - SMOOTHING_FACTOR );
 
+	LeanThink();											// (torbensko)
+
 	if ( !g_fGameOver && !m_iPlayerLocked )
 	{
 		if ( IsAlive() )
@@ -7771,6 +7777,8 @@ void SendProxy_CropFlagsToPlayerFlagBitsLength( const SendProp *pProp, const voi
 		SendPropInt			( SENDINFO( m_nWaterLevel ), 2, SPROP_UNSIGNED ),
 		SendPropFloat		( SENDINFO( m_flLaggedMovementValue ), 0, SPROP_NOSCALE ),
 
+		HAL_LEAN_SENDPROPS										// (torbensko)
+
 	END_SEND_TABLE()
 
 
@@ -17,6 +17,7 @@
 #include "game/server/iplayerinfo.h"
 #include "hintsystem.h"
 #include "SoundEmitterSystem/isoundemittersystembase.h"
+#include "hal/player_lean.h"			// (torbensko)
 
 // For queuing and processing usercmds
 class CCommandContext
@@ -1141,12 +1142,16 @@ public:
 	void	InputUseDefaultBloomScale( inputdata_t &inputdata );
 //	void	InputSetBloomScaleRange( inputdata_t &inputdata );
 
+	HAL_LEAN_MEMBERS								// (torbensko)
+
 public:												// (torbensko)
-	void	PerformLean(float amount);				// (torbensko)
+	void	RunLean(float amount);					// (torbensko)
+	bool	TakeQueuedLean(float &amount);			// (torbensko)
+	void	FlushQueuedLean();						// (torbensko)
 
 private:											// (torbensko)
-	float	m_movementReserve;						// (torbensko)
-	float	m_leanAmount_p;							// (torbensko)
+	float	m_queuedLean;							// (torbensko)
+	bool	m_leanQueued;							// (torbensko)
 };
 
 typedef CHandle<CBasePlayer> CBasePlayerHandle;
@@ -414,57 +414,27 @@ void CBaseViewModel::CalcViewModelView( CBasePlayer *owner, const Vector& eyePos
 		vieweffects->ApplyShake( vmorigin, vmangles, 0.1 );   
 	}
 
-	Vector offset;
-	float lean = UTIL_GetLeanAmount();
-	float easedLean = pow(fabs(lean), hal_weapon_ease.GetFloat());
-	
-	if(lean > 0.0f)
-	{
-		vmangles[PITCH]	+= pWeapon->GetWpnData().leanLeftAngOffset[PITCH]	* lean;
-		vmangles[ROLL]	+= pWeapon->GetWpnData().leanLeftAngOffset[ROLL]	* easedLean;
-		vmangles[YAW]	+= pWeapon->GetWpnData().leanLeftAngOffset[YAW]		* lean;
-
-		offset			 = pWeapon->GetWpnData().leanLeftPosOffset;
-	}
-	else
-	{
-		vmangles[PITCH]	+= pWeapon->GetWpnData().leanRightAngOffset[PITCH]	* -lean;
-		vmangles[ROLL]	+= pWeapon->GetWpnData().leanRightAngOffset[ROLL]	*  easedLean;
-		vmangles[YAW]	+= pWeapon->GetWpnData().leanRightAngOffset[YAW]	* -lean;
-		offset			 = pWeapon->GetWpnData().leanRightPosOffset;
-
-	}
-
-	// get eye direction angles
-	Vector forward, right, up; 
-	//AngleVectors(vmangles, &forward, &right, &up);
-	AngleVectors(eyeAngles, &forward, &right, &up);
-	
-	// apply the offsets
-	vmorigin	+= forward   * offset.x;
-	vmorigin	+= right     * offset.y;
-	vmorigin	+= up        * offset.z;
-
-	Vector difPos(vmorigin - eyePosition);
-	vmorigin = eyePosition + (difPos * lean);
-
-	vmangles		+= pWeapon->GetWpnData().neutralAngOffset;
-	Vector neutral	 = pWeapon->GetWpnData().neutralPosOffset;
-	vmorigin		+= forward   * neutral.x;
-	vmorigin		+= right     * neutral.y;
-	vmorigin		+= up        * neutral.z;
-
-	float lookDown = UTIL_GetHandycamShake().pitch / -hal_weapon_pullback.GetFloat();
-	if(lookDown > 0.0f)
-	{
-		lookDown = SimpleSpline(clamp(lookDown, 0.0f, 1.0f));
-
-		vmangles			+= pWeapon->GetWpnData().retractAngOffset	* lookDown;
-		Vector retractDist   = pWeapon->GetWpnData().retractPosOffset;
-		vmorigin			+= forward   * retractDist.x	* lookDown;
-		vmorigin			+= right     * retractDist.y	* lookDown;
-		vmorigin			+= up        * retractDist.z	* lookDown;
-	}
+	// The local player's lean comes from the interpolated head pose, as the
+	// predicted lean only changes once per command and would tilt the weapon in
+	// steps at high frame rates. Anyone else's follows their networked lean
+	float lean		= (owner && !owner->IsLocalPlayer()) ? owner->GetLeanAmount() : UTIL_GetLeanAmount();
+	float pullBack	= UTIL_GetHandycamShake().pitch / -hal_weapon_pullback.GetFloat();
+
+	// The lean, neutral and retract offsets in eye space (x forward, y right
+	// and z up), as precompiled from the weapon script
+	Vector local;
+	QAngle angles;
+	pWeapon->GetWpnData().leanPoses.Lookup(lean, pullBack, hal_weapon_ease.GetFloat(), local, angles);
+	vmangles += angles;
+
+	// the matrix's y axis points left
+	matrix3x4_t eye;
+	Vector world;
+	AngleMatrix(eyeAngles, eye);
+	VectorRotate(Vector(local.x, -local.y, local.z), eye, world);
+
+	// the bob and lag are scaled along with the lean
+	vmorigin = eyePosition + (vmorigin - eyePosition) * lean + world;
 
 	SetLocalOrigin(vmorigin);
 	SetLocalAngles(vmangles);
@@ -0,0 +1,33 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_AIM_TRACE_H
+#define HAL_AIM_TRACE_H
+
+#include "gametrace.h"
+
+#define AIM_TRACE_CACHE_SIZE	4
+
+
+// Traces a MAX_TRACE_LENGTH ray from the eye. A cached result is reused across
+// frames until the ray moves beyond the tolerances (hal_aimTrace*) or it
+// becomes too old (hal_aimTraceMaxFrames). The cache is cleared on level change.
+//
+// The crosshair is the only caller in this tree. Any other eye trace made with
+// the same mask, filter and collision group can share its result.
+const trace_t&	UTIL_CachedAimTrace(const Vector &start, const Vector &direction, unsigned int mask, 
+								   IHandleEntity *ignore, int collisionGroup);
+
+void			UTIL_ClearAimTraceCache();
+
+#endif
@@ -0,0 +1,107 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+
+#include "igamesystem.h"
+#include "hal/aim_trace.h"
+
+ConVar hal_aimTraceMoveTolerance("hal_aimTraceMoveTolerance", "0.25", 0, "How far (in units) the eye can move before the aim is traced again");
+ConVar hal_aimTraceTurnTolerance("hal_aimTraceTurnTolerance", "0.05", 0, "How far (in degrees) the eye can turn before the aim is traced again");
+ConVar hal_aimTraceMaxFrames("hal_aimTraceMaxFrames", "4", 0, "The most frames an aim trace is reused for, so that anything moving across a still aim is picked up (1 = the current frame only)");
+
+
+class AimTraceEntry
+{
+public:
+	AimTraceEntry()
+		: valid(false), mask(0), ignore(NULL), collisionGroup(0), frame(0), lastUsed(0) {};
+
+	bool			valid;
+	Vector			start;
+	Vector			direction;
+	unsigned int	mask;
+	IHandleEntity	*ignore;
+	int				collisionGroup;
+	int				frame;
+	int				lastUsed;
+	trace_t			trace;
+};
+
+static AimTraceEntry	s_aimTraces[AIM_TRACE_CACHE_SIZE];
+static int				s_aimTraceUses = 0;
+
+
+const trace_t& UTIL_CachedAimTrace(const Vector &start, const Vector &direction, unsigned int mask, 
+								   IHandleEntity *ignore, int collisionGroup)
+{
+	int now = gpGlobals->framecount;
+	int maxFrames = max(hal_aimTraceMaxFrames.GetInt(), 1);
+	float moveTol = hal_aimTraceMoveTolerance.GetFloat();
+	float turnTol = cos(DEG2RAD(hal_aimTraceTurnTolerance.GetFloat()));
+
+	AimTraceEntry *oldest = &s_aimTraces[0];
+	s_aimTraceUses++;
+
+	for(int i = 0; i < AIM_TRACE_CACHE_SIZE; i++)
+	{
+		AimTraceEntry &entry = s_aimTraces[i];
+
+		if(entry.lastUsed < oldest->lastUsed)
+			oldest = &entry;
+
+		if(!entry.valid || entry.mask != mask || entry.ignore != ignore || entry.collisionGroup != collisionGroup)
+			continue;
+
+		if(now < entry.frame || now - entry.frame >= maxFrames)
+			continue;
+
+		if(	entry.start.DistToSqr(start) > moveTol * moveTol ||
+			DotProduct(entry.direction, direction) < turnTol)
+			continue;
+
+		entry.lastUsed = s_aimTraceUses;
+		return entry.trace;
+	}
+
+	// nothing close enough, so replace the least recently used entry
+	oldest->valid			= true;
+	oldest->start			= start;
+	oldest->direction		= direction;
+	oldest->mask			= mask;
+	oldest->ignore			= ignore;
+	oldest->collisionGroup	= collisionGroup;
+	oldest->frame			= now;
+	oldest->lastUsed		= s_aimTraceUses;
+
+	UTIL_TraceLine(start, start + direction * MAX_TRACE_LENGTH, mask, ignore, collisionGroup, &oldest->trace);
+	return oldest->trace;
+}
+
+void UTIL_ClearAimTraceCache()
+{
+	for(int i = 0; i < AIM_TRACE_CACHE_SIZE; i++)
+		s_aimTraces[i].valid = false;
+}
+
+
+// The cached entities (and the frame count) don't survive a level change
+class AimTraceCacheSystem : public CAutoGameSystem
+{
+public:
+	AimTraceCacheSystem( char const *name = NULL ) : CAutoGameSystem( name ) {}
+	void LevelInitPreEntity()		{ UTIL_ClearAimTraceCache(); }
+	void LevelShutdownPreEntity()	{ UTIL_ClearAimTraceCache(); }
+};
+
+AimTraceCacheSystem aimTraceCacheSystem("aimTraceCache");
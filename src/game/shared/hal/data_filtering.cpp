@@ -19,6 +19,29 @@ PARTICULAR PURPOSE.
 
 #define EASE_MAX_POWER 2
 
+// How quickly the bridge follows changes in the frame interval and velocity
+#define BRIDGE_INTERVAL_RATE	0.05f
+#define BRIDGE_VELOCITY_TIME	0.1f
+
+// Turn the median absolute deviation and the interquartile range into
+// standard deviations (for normally distributed noise)
+#define OUTLIER_MAD_SCALE	1.4826f
+#define OUTLIER_IQR_SCALE	(1 / 1.349f)
+
+// How quickly each channel's noise estimate follows the accepted samples.
+// The mean absolute deviation is scaled to a standard deviation as above
+#define OUTLIER_NOISE_RATE	0.05f
+#define OUTLIER_NOISE_SCALE	1.2533f
+
+// Puts the smaller of a and b in a. Without any branches, so that the
+// sorting network below compiles to straight min and max instructions
+#define SORT_PAIR(v, a, b) \
+{ \
+	float low = min(v[a], v[b]); \
+	v[b] = max(v[a], v[b]); \
+	v[a] = low; \
+}
+
 
 #define CREATE_CONVAR(name, val, min, max) \
 	TunableVar hal_##name = TunableVar("hal_"#name, #val, FCVAR_ARCHIVE, "", true, min, true, max);
@@ -31,6 +54,7 @@ CREATE_CONVAR(leanRollRange_deg,					20, 0, 90);
 CREATE_CONVAR(leanStabilise_p,						50, 0, 100);
 CREATE_CONVAR(leanSmoothing_sec,					0.2, 0.05, 1);
 CREATE_CONVAR(leanEaseIn_p,							50, 0, 100);
+CREATE_CONVAR(leanFOV,								12, 0, 45);
 
 CREATE_CONVAR(handyScale_f,							1, 0, 2);
 CREATE_CONVAR(handyScalePitch_f,					1, 0, 3);
@@ -40,6 +64,7 @@ CREATE_CONVAR(handyScaleVert_f,						1, 0, 3);
 CREATE_CONVAR(handyScaleSidew_f,					1, 0, 3);
 
 CREATE_CONVAR(handySmoothing_sec,					0.1, 0, 0.5);
+CREATE_CONVAR(handyOrientation,						1, 0, 1);	// see OrientationFilter
 
 CREATE_CONVAR(handyMaxPitch_deg,					30, 0, 90);
 CREATE_CONVAR(handyMaxYaw_deg,						30, 0, 90);
@@ -55,6 +80,27 @@ CREATE_CONVAR(adaptSmoothAmount_p,					100, 0, 300);
 
 CREATE_CONVAR(fadingDuration_s,						1, 0, 5);
 
+// Interpolating the poses between the camera frames. By default the newest
+// pose is extrapolated to the render time, the delay is an opt-in
+CREATE_CONVAR(poseInterpolate,						1, 0, 1);
+CREATE_CONVAR(poseDelayFrames,						0, 0, 3);
+CREATE_CONVAR(poseExtrapolate_s,					0.04, 0, 0.1);
+
+// Learning the player's neutral head position
+CREATE_CONVAR(neutralTime_s,						60, 1, 600);
+CREATE_CONVAR(neutralSeed_s,						2, 0, 60);
+
+// Bridging short tracking drop-outs
+CREATE_CONVAR(bridgeFrames,							4, 0, 30);
+CREATE_CONVAR(bridgeMax_s,							0.25, 0, 1);
+CREATE_CONVAR(bridgeDecay_s,						0.05, 0, 0.5);
+CREATE_CONVAR(bridgeBlend_s,						0.1, 0, 1);
+
+// Rejecting glitches from the tracker (0 disables)
+CREATE_CONVAR(outlierWindow,						5, 0, 64);
+CREATE_CONVAR(outlierThreshold,						3, 0, 10);
+CREATE_CONVAR(outlierMin,							2, 0, 10);	// cm or deg
+
 
 float SumFilter::Update(FaceAPIData headData)
 {
@@ -167,48 +213,57 @@ float EaseInFilter::Update(float value)
 
 // MeanOffsetFilter
 
+// Caps the time a single sample can cover, so the first one after a tracking
+// drop-out isn't given the weight of the entire gap
+#define NEUTRAL_MAX_STEP 0.1f
+
 float MeanOffsetFilter::Update(float value) 
 {
-	m_sum += value;
-	m_count++;
+	float now = ENGINE_NOW;
+	float step = (m_lastSample > 0) ? clamp(now - m_lastSample, 0, NEUTRAL_MAX_STEP) : NEUTRAL_MAX_STEP;
+	m_lastSample = now;
 
-	return value - m_sum/m_count;
+	double decay = exp(-step / hal_neutralTime_s.GetFloat());
+	double weight = (m_weight > 0) ? GetWeight(value) * step : step;
+
+	m_sum = m_sum * decay + value * weight;
+	m_weight = m_weight * decay + weight;
+
+	return (m_weight > 0) ? value - (float)(m_sum / m_weight) : 0.0f;
 }
 
 void MeanOffsetFilter::Reset() 
 {
 	Filter::Reset();
 	m_sum = 0;
-	m_count = 0;
-}
+	m_weight = 0;
+	m_lastSample = 0;
 
+	if(m_seeded)
+		SetNeutral(m_seed);
+}
 
+void MeanOffsetFilter::SetNeutral(float neutral)
+{
+	m_seeded = true;
+	m_seed = neutral;
 
-// WeightedMeanOffsetFilter
+	m_weight = hal_neutralSeed_s.GetFloat();
+	m_sum = neutral * m_weight;
+}
 
-float WeightedMeanOffsetFilter::Update(float value) 
+float MeanOffsetFilter::GetNeutral() const
 {
-	if(m_count == 0.0f) 
-	{
-		m_sum += value;
-		m_count++;
-	} 
-	else 
-	{
-		float weight = (m_range->GetFloat() > 0) ? fabs(GetValue() - value) / m_range->GetFloat() : 1;
-		
-		m_sum += value * weight;
-		m_count += weight;
-	}
-
-	return value - m_sum/m_count;
+	return (m_weight > 0) ? (float)(m_sum / m_weight) : 0.0f;
 }
 
-void WeightedMeanOffsetFilter::Reset() 
+
+
+// WeightedMeanOffsetFilter
+
+float WeightedMeanOffsetFilter::GetWeight(float value) 
 {
-	Filter::Reset();
-	m_sum = 0;
-	m_count = 0;
+	return (m_range->GetFloat() > 0) ? fabs(GetValue() - value) / m_range->GetFloat() : 1;
 }
 
 
@@ -315,3 +370,270 @@ float LimitFilter::Update(float value)
 	x = x/3 + 0.5;
 	return (6*x*x - 4*x*x*x - 1) * range * SIGN_OF(value);
 }
+
+
+
+// BridgeFilter
+
+void BridgeFilter::Reset()
+{
+	Filter::Reset();
+	m_interval = 0;
+	m_confidence = 0;
+	m_lastFrameNum = 0;
+	m_lastFrameTime = 0;
+
+	m_lastValue = 0;
+	m_lastValueTime = 0;
+	m_velocity = 0;
+
+	m_gapStart = 0;
+	m_gapValue = 0;
+	m_fading = false;
+
+	m_blendOffset = 0;
+	m_blendStart = 0;
+
+	// it stands in for the top of the chain, so the reset is passed on
+	if(m_parent)
+		m_parent->Reset();
+}
+
+float BridgeFilter::GetThreshold()
+{
+	if(m_interval <= 0)
+		return 0;
+
+	float confRange = hal_adaptSmoothMaxConf_f.GetFloat() - hal_adaptSmoothMinConf_f.GetFloat();
+	float trust = (confRange > 0) ? clamp((m_confidence - hal_adaptSmoothMinConf_f.GetFloat()) / confRange, 0, 1) : 1;
+
+	return min(hal_bridgeFrames.GetFloat() * m_interval, hal_bridgeMax_s.GetFloat()) * trust;
+}
+
+void BridgeFilter::StartBlend(float offset)
+{
+	m_blendOffset = offset;
+	m_blendStart = ENGINE_NOW;
+}
+
+float BridgeFilter::GetBlend()
+{
+	if(m_blendOffset == 0.0f || hal_bridgeBlend_s.GetFloat() <= 0)
+		return 0.0f;
+
+	float p = clamp((ENGINE_NOW - m_blendStart) / hal_bridgeBlend_s.GetFloat(), 0, 1);
+	if(p >= 1)
+		m_blendOffset = 0.0f;
+
+	return (1 - SimpleSpline(p)) * m_blendOffset;
+}
+
+float BridgeFilter::Update(FaceAPIData headData)
+{
+	float now = ENGINE_NOW;
+	if(now == m_lastUpdate)
+		return m_pValue;
+
+	// The frame interval is only learnt while tracking, so the gaps themselves
+	// don't stretch it
+	if(headData.h_frameNum != m_lastFrameNum)
+	{
+		float step = headData.h_time - m_lastFrameTime;
+		if(m_lastFrameTime > 0 && m_gapStart == 0 && step > 0)
+			m_interval = (m_interval > 0) ? m_interval + (step - m_interval) * BRIDGE_INTERVAL_RATE : step;
+
+		m_lastFrameNum = headData.h_frameNum;
+		m_lastFrameTime = headData.h_time;
+		m_confidence = headData.h_confidence;
+	}
+
+	float value = m_parent->Update(headData);
+
+	if(m_gapStart > 0)
+	{
+		// tracking is back, so blend from wherever the bridge (or fade) got to
+		StartBlend(m_pValue - value);
+		m_gapStart = 0;
+		m_fading = false;
+		m_velocity = 0;
+	}
+	else if(m_lastValueTime > 0 && now > m_lastValueTime)
+	{
+		float dt = now - m_lastValueTime;
+		m_velocity += ((value - m_lastValue) / dt - m_velocity) * clamp(dt / BRIDGE_VELOCITY_TIME, 0, 1);
+	}
+
+	m_lastValue = value;
+	m_lastValueTime = now;
+
+	m_pValue = value + GetBlend();
+	m_lastUpdate = now;
+	return m_pValue;
+}
+
+// Called instead of the above while there is no tracking
+float BridgeFilter::Update()
+{
+	float now = ENGINE_NOW;
+	if(now == m_lastUpdate)
+		return m_pValue;
+
+	if(m_gapStart == 0)
+	{
+		m_gapStart = now;
+		m_gapValue = m_pValue;
+	}
+
+	float gap = now - m_gapStart;
+	if(!m_fading && gap <= GetThreshold())
+	{
+		// the velocity decays away, so the value settles rather than running off
+		float decay = hal_bridgeDecay_s.GetFloat();
+		m_pValue = m_gapValue + ((decay > 0) ? m_velocity * decay * (1 - exp(-gap / decay)) : 0);
+	}
+	else
+	{
+		float faded = m_parent->Update();
+		if(!m_fading)
+		{
+			StartBlend(m_pValue - faded);
+			m_fading = true;
+		}
+		m_pValue = faded + GetBlend();
+	}
+
+	m_lastUpdate = now;
+	return m_pValue;
+}
+
+
+
+// OutlierFilter
+
+// Sorts 8 values with Batcher's odd-even merge sort (19 comparisons). Smaller
+// windows are padded out with FLT_MAX
+static void SortEight(float *v)
+{
+	SORT_PAIR(v, 0, 1); SORT_PAIR(v, 2, 3); SORT_PAIR(v, 4, 5); SORT_PAIR(v, 6, 7);
+	SORT_PAIR(v, 0, 2); SORT_PAIR(v, 1, 3); SORT_PAIR(v, 4, 6); SORT_PAIR(v, 5, 7);
+	SORT_PAIR(v, 1, 2); SORT_PAIR(v, 5, 6);
+	SORT_PAIR(v, 0, 4); SORT_PAIR(v, 1, 5); SORT_PAIR(v, 2, 6); SORT_PAIR(v, 3, 7);
+	SORT_PAIR(v, 2, 4); SORT_PAIR(v, 3, 5);
+	SORT_PAIR(v, 1, 2); SORT_PAIR(v, 3, 4); SORT_PAIR(v, 5, 6);
+}
+
+void OutlierFilter::Reset()
+{
+	Filter::Reset();
+	m_size = 0;
+	m_count = 0;
+	m_next = 0;
+	m_samples = 0;
+	m_lastFrameNum = 0;
+	m_noise = 0;
+	m_outside = 0;
+	m_last = 0;
+	m_ranks.Clear();
+}
+
+float OutlierFilter::Update(FaceAPIData headData)
+{
+	if(m_samples > 0 && headData.h_frameNum == m_lastFrameNum)
+		return m_pValue;
+
+	m_lastFrameNum = headData.h_frameNum;
+
+	float val = (m_parent) ? m_parent->Update(headData) : headData.h_headPos[m_dataIndex];
+	m_pValue = Update(val);
+	return m_pValue;
+}
+
+float OutlierFilter::Update(float value)
+{
+	int size = clamp(hal_outlierWindow.GetInt(), 0, OUTLIER_MAX_WINDOW);
+	if(size != m_size)
+	{
+		Reset();
+		m_size = size;
+	}
+
+	if(m_size < 3)
+		return value;
+
+	// replace the oldest sample
+	if(m_count == m_size)
+	{
+		if(m_size > OUTLIER_SMALL_WINDOW)
+			m_ranks.Remove(m_window[m_next], m_samples - m_size);
+	}
+	else
+	{
+		m_count++;
+	}
+
+	if(m_size > OUTLIER_SMALL_WINDOW)
+		m_ranks.Insert(value, m_samples);
+
+	m_window[m_next] = value;
+	m_next = (m_next + 1) % m_size;
+	m_samples++;
+
+	if(m_count < 3 || hal_outlierThreshold.GetFloat() <= 0)
+	{
+		m_last = value;
+		return value;
+	}
+
+	float median, deviation;
+	if(m_size > OUTLIER_SMALL_WINDOW)
+		GetLargeWindow(m_count, median, deviation);
+	else
+		GetSmallWindow(m_count, median, deviation);
+
+	// A still head gives a deviation of zero, so the limit never drops below
+	// the noise the channel has shown recently or the fixed floor
+	float offset = value - median;
+	float limit = hal_outlierThreshold.GetFloat() * max(deviation, m_noise);
+	limit = max(limit, hal_outlierMin.GetFloat());
+
+	if(fabs(offset) <= limit)
+	{
+		m_noise += (fabs(offset) * OUTLIER_NOISE_SCALE - m_noise) * OUTLIER_NOISE_RATE;
+		m_outside = 0;
+		m_last = value;
+		return value;
+	}
+
+	// A glitch lasts a single sample. If the previous sample was out the same
+	// way then the head has really moved, and the window just hasn't caught up
+	int side = (offset > 0) ? 1 : -1;
+	bool moved = (side == m_outside);
+	m_outside = side;
+
+	// Holding the last sample rather than jumping back to the median keeps
+	// a movement that starts quickly from stepping backwards
+	if(moved)
+		m_last = value;
+	return m_last;
+}
+
+void OutlierFilter::GetSmallWindow(int count, float &median, float &deviation)
+{
+	float sorted[8];
+	for(int i = 0; i < 8; i++)
+		sorted[i] = (i < count) ? m_window[i] : FLT_MAX;
+	SortEight(sorted);
+	median = sorted[count / 2];
+
+	for(int i = 0; i < 8; i++)
+		sorted[i] = (i < count) ? fabs(sorted[i] - median) : FLT_MAX;
+	SortEight(sorted);
+	deviation = sorted[count / 2] * OUTLIER_MAD_SCALE;
+}
+
+void OutlierFilter::GetLargeWindow(int count, float &median, float &deviation)
+{
+	int quartile = (count - 1) / 4;
+	median = m_ranks.Select(count / 2);
+	deviation = (m_ranks.Select(count - 1 - quartile) - m_ranks.Select(quartile)) * OUTLIER_IQR_SCALE;
+}
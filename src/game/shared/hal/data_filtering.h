@@ -16,7 +16,8 @@ PARTICULAR PURPOSE.
 
 #include <map>
 #include <vector>
-#include "hal/faceapi.h"
+#include "hal/head_tracker.h"
+#include "hal/order_statistics.h"
 #include "engine_dependencies.h"
 
 
@@ -28,6 +29,7 @@ extern TunableVar hal_leanRollRange_deg;
 extern TunableVar hal_leanStabilise_p;
 extern TunableVar hal_leanSmoothing_sec;
 extern TunableVar hal_leanEaseIn_p;
+extern TunableVar hal_leanFOV;
 
 extern TunableVar hal_handyScale_f;
 extern TunableVar hal_handyScalePitch_f;
@@ -37,6 +39,7 @@ extern TunableVar hal_handyScaleVert_f;
 extern TunableVar hal_handyScaleSidew_f;
 
 extern TunableVar hal_handySmoothing_sec;
+extern TunableVar hal_handyOrientation;
 
 extern TunableVar hal_handyMaxPitch_deg;
 extern TunableVar hal_handyMaxYaw_deg;
@@ -52,6 +55,22 @@ extern TunableVar hal_adaptSmoothAmount_p;
 
 extern TunableVar hal_fadingDuration_s;
 
+extern TunableVar hal_poseInterpolate;
+extern TunableVar hal_poseDelayFrames;
+extern TunableVar hal_poseExtrapolate_s;
+
+extern TunableVar hal_neutralTime_s;
+extern TunableVar hal_neutralSeed_s;
+
+extern TunableVar hal_bridgeFrames;
+extern TunableVar hal_bridgeMax_s;
+extern TunableVar hal_bridgeDecay_s;
+extern TunableVar hal_bridgeBlend_s;
+
+extern TunableVar hal_outlierWindow;
+extern TunableVar hal_outlierThreshold;
+extern TunableVar hal_outlierMin;
+
 
 class Filter
 {
@@ -206,39 +225,55 @@ private:
 
 
 
-// Computes the running mean and subtracts it from the current value
+// Tracks the neutral (resting) position and subtracts it from the current
+// value. The neutral is an exponentially weighted mean over the last
+// hal_neutralTime_s, with each sample weighted by the time it covers, so the
+// accumulated weight is bounded by the time constant however long the
+// session runs. A saved calibration can be used to seed it (see SetNeutral)
 class MeanOffsetFilter: public Filter
 {
 public:
-	MeanOffsetFilter(int dataIndex): Filter(dataIndex) { Reset(); }
+	MeanOffsetFilter(int dataIndex): Filter(dataIndex), m_seeded(false), m_seed(0) { Reset(); }
 
 	void Reset();
 	float Update(float value);
 	virtual char* GetClass() { return "MeanOffsetFilter"; }
 
-private:
-	float m_sum;
-	int m_count;
+	// Starts the mean from a known neutral, worth hal_neutralSeed_s of samples
+	void SetNeutral(float neutral);
+	float GetNeutral() const;
+	bool HasNeutral() const { return m_weight > 0; }
+
+protected:
+	// The relative weight of a new sample
+	virtual float GetWeight(float value) { return 1; }
+
+	double m_sum;
+	double m_weight;
+	float m_lastSample;
+
+	// the saved calibration, which a reset returns to
+	bool m_seeded;
+	float m_seed;
 };
 
 
 
-// Computes the running mean and subtracts it from the current value. The mean
-// is only updated when the new values are close to the current mean
-class WeightedMeanOffsetFilter: public Filter
+// As above, although the samples close to the current mean contribute less,
+// which keeps the neutral from drifting while the player holds a lean
+class WeightedMeanOffsetFilter: public MeanOffsetFilter
 {
 public:
 	WeightedMeanOffsetFilter(int dataIndex, TunableVar *range) 
-		: Filter(dataIndex), m_range(range) { Reset(); }
+		: MeanOffsetFilter(dataIndex), m_range(range) {}
 
-	void Reset();
-	float Update(float value);
 	virtual char* GetClass() { return "WeightedMeanOffsetFilter"; }
 
+protected:
+	float GetWeight(float value);
+
 private:
 	TunableVar *m_range;
-	float m_sum;
-	float m_count;
 };
 
 
@@ -300,4 +335,96 @@ private:
 
 
 
+// Carries the value across short tracking drop-outs (a blink, a hand passing
+// the camera), so a held lean doesn't start fading straight away. The last
+// good value keeps moving with a decaying velocity, and the parent (usually a
+// FadeFilter) is only told about the drop-out once the gap gets longer than
+// hal_bridgeFrames of the tracker's frames. The threshold shrinks with the
+// confidence of the last frame, as a pose the tracker was unsure of is not
+// worth holding on to. Any jump, when the tracking comes back or the fading
+// starts, is blended out over hal_bridgeBlend_s
+class BridgeFilter: public Filter
+{
+public:
+	BridgeFilter(Filter *parent) : Filter(parent) { Reset(); }
+
+	void Reset();
+	float Update(FaceAPIData headData);
+	float Update();
+	virtual char* GetClass() { return "BridgeFilter"; }
+
+	// The longest gap that is bridged, or zero until the frame rate is known
+	float GetThreshold();
+
+private:
+	void StartBlend(float offset);
+	float GetBlend();
+
+	// learnt from the tracker
+	float m_interval;
+	float m_confidence;
+	unsigned int m_lastFrameNum;
+	float m_lastFrameTime;
+
+	// the last good value and how it was moving
+	float m_lastValue;
+	float m_lastValueTime;
+	float m_velocity;
+
+	float m_gapStart;
+	float m_gapValue;
+	bool m_fading;
+
+	float m_blendOffset;
+	float m_blendStart;
+};
+
+
+
+// Windows up to this size are sorted outright, anything larger is kept in
+// an OrderStatistics
+#define OUTLIER_SMALL_WINDOW	7
+#define OUTLIER_MAX_WINDOW		ORDER_STATISTICS_SIZE
+
+// Removes single frame glitches from the tracker before they reach the rest
+// of the filters (a Hampel filter). A sample more than hal_outlierThreshold
+// deviations from the median of the last hal_outlierWindow samples is
+// replaced by the last good sample. The deviation is the median absolute deviation
+// for the small windows and from the quartiles for the larger ones, as only
+// the ranks can be found without going through the whole window.
+//
+// Only the first sample of a real movement is held back: once a second one
+// lands on the same side of the median it is let through.
+//
+// It works on the tracker's samples rather than the game's frames, so it
+// only takes a new value when the frame number changes
+class OutlierFilter: public Filter
+{
+public:
+	OutlierFilter(int dataIndex) : Filter(dataIndex) { Reset(); }
+
+	void Reset();
+	float Update(FaceAPIData headData);
+	float Update(float value);
+	virtual char* GetClass() { return "OutlierFilter"; }
+
+private:
+	void GetSmallWindow(int count, float &median, float &deviation);
+	void GetLargeWindow(int count, float &median, float &deviation);
+
+	int m_size;
+	float m_window[OUTLIER_MAX_WINDOW];		// the last m_size samples
+	int m_count;
+	int m_next;
+	unsigned int m_samples;
+	unsigned int m_lastFrameNum;
+	float m_noise;		// running estimate of the channel's deviation
+	int m_outside;		// side of the median the last outlier was on, or 0
+	float m_last;		// the last sample let through
+
+	OrderStatistics m_ranks;
+};
+
+
+
 #endif
\ No newline at end of file
@@ -17,6 +17,7 @@ PARTICULAR PURPOSE.
 #include "convar.h"
 
 #define ENGINE_NOW engine->Time() 
+#define ENGINE_FRAME gpGlobals->framecount
 
 //gpGlobals->curtime
 
@@ -34,116 +34,131 @@ using namespace std;
 	engine_printf("faceAPI: %d\n", result); \
 }
 
-FaceAPIData::FaceAPIData()
-{
-	h_headPos[FACEAPI_ROLL] = 0.0f;
-	h_headPos[FACEAPI_PITCH] = 0.0f;
-	h_headPos[FACEAPI_YAW] = 0.0f;
-	h_headPos[FACEAPI_VERT] = 0.0f;
-	h_headPos[FACEAPI_SIDEW] = 0.0f;
-	h_headPos[FACEAPI_DEPTH] = 0.0f;
-
-	h_confidence = 0.0f;
-	h_frameNum = 0;
+// As above, although a failure stops the tracking from starting
+#define FAIL_ON_ERROR(x) \
+{ \
+	smReturnCode result = (x); \
+	if(result != SM_API_OK) \
+	{ \
+		engine_sprintf(m_initError, sizeof(m_initError), "%s failed (%d)", #x, result); \
+		return false; \
+	} \
+}
+
+// Starting the camera takes a while, so a shutdown is checked for between
+// each of the slower steps
+#define FAIL_ON_STOP() \
+{ \
+	if(IsStopping()) \
+	{ \
+		engine_sprintf(m_initError, sizeof(m_initError), "cancelled"); \
+		return false; \
+	} \
 }
 
-FaceAPI*	_faceapi;
+// The shortest time the fetcher waits for a frame
+#define FACEAPI_MIN_WAIT_MS	10
+
+REGISTER_HEAD_TRACKER(FaceAPI, "faceapi", "Seeing Machines' faceAPI, using a webcam");
 
 #ifdef USE_FACEAPI_4
 
-bool _faceapi_fetcher_running;
-void __cdecl FaceAPI_dataFetcher(void *)
+int FaceAPI::FetchThread::Run()
 {
-	_faceapi_fetcher_running = true;
-	while(_faceapi->InternalDataFetch()) {}
-	_faceapi_fetcher_running = false;
-	_endthread();
+	while(m_faceAPI->InternalDataFetch()) {}
+	return 0;
 }
 
 // How we fetch the head data differs between FaceAPI 3 and 4
 
 bool FaceAPI::InternalDataFetch()
 {
-	if(!engine_handle || m_shuttingDown)
+	if(!engine_handle || IsStopping())
 		return false;
 
-	float now = ENGINE_NOW;
+	// wait for no more than about a frame, so a shutdown is noticed quickly
+	unsigned int timeout = (m_rate > 0) ? max((int)(1000 / m_rate), FACEAPI_MIN_WAIT_MS) : FACEAPI_MIN_WAIT_MS;
 
 	smEngineData enginedata;
-	smReturnCode result = smEngineDataWaitNext(engine_handle, &enginedata, 5000);
+	smReturnCode result = smEngineDataWaitNext(engine_handle, &enginedata, timeout);
 
 	if(result != SM_API_OK)
 	{
-		engine_printf("error fetching faceAPI data\n");
+		// only reported once per stall, as the wait is now short
+		if(!m_fetchFailing)
+			engine_printf("error fetching faceAPI data (%d)\n", result);
+		m_fetchFailing = true;
 	}
 	else
 	{
-		m_data[m_nextData].h_height			= enginedata.head_pose_data->head_pos.y;
-		m_data[m_nextData].h_width			= enginedata.head_pose_data->head_pos.x;
-		m_data[m_nextData].h_depth			= enginedata.head_pose_data->head_pos.z;
-		m_data[m_nextData].h_yaw			= enginedata.head_pose_data->head_rot.y_rads;
-		m_data[m_nextData].h_pitch			= enginedata.head_pose_data->head_rot.x_rads;
-		m_data[m_nextData].h_roll			= enginedata.head_pose_data->head_rot.z_rads;
-		m_data[m_nextData].h_confidence		= enginedata.head_pose_data->confidence;
-
-		m_data[m_nextData].h_frameNum		= enginedata.video_frame.frame_num;
-		m_data[m_nextData].h_frameDuration	= now - m_lastUpdate;
-
-		m_currData = m_nextData;
-		m_nextData = (m_nextData + 1) % 3;
-		
-		m_lastUpdate = now;
+		m_fetchFailing = false;
+
+		const smEngineHeadPoseData &head_pose = *enginedata.head_pose_data;
+		FaceAPIData &data = GetWriteData();
+
+		data.h_headPos[FACEAPI_VERT]	= METERS_TO_CMS(head_pose.head_pos.y);
+		data.h_headPos[FACEAPI_SIDEW]	= -METERS_TO_CMS(head_pose.head_pos.x);
+		data.h_headPos[FACEAPI_DEPTH]	= METERS_TO_CMS(head_pose.head_pos.z);
+		data.h_headPos[FACEAPI_YAW]		= RAD_TO_DEG(head_pose.head_rot.y_rads);
+		data.h_headPos[FACEAPI_PITCH]	= RAD_TO_DEG(head_pose.head_rot.x_rads);
+		data.h_headPos[FACEAPI_ROLL]	= RAD_TO_DEG(head_pose.head_rot.z_rads);
+
+		data.h_confidence	= head_pose.confidence;
+		data.h_frameNum		= enginedata.video_frame.frame_num;
+		data.h_time			= ENGINE_NOW;
+
+		PublishData();
 	}
 	
 	smEngineDataDestroy(&enginedata);
 	return true;
 }
 #else
-void STDCALL receiveHeadPose(void *, smEngineHeadPoseData head_pose, smCameraVideoFrame video_frame)
+void STDCALL receiveHeadPose(void *faceAPI, smEngineHeadPoseData head_pose, smCameraVideoFrame video_frame)
 {
-	_faceapi->SetData(head_pose);
+	((FaceAPI*)faceAPI)->SetData(head_pose, video_frame);
 }
  
-void FaceAPI::SetData(smEngineHeadPoseData head_pose)
+void FaceAPI::SetData(smEngineHeadPoseData head_pose, smCameraVideoFrame video_frame)
 {
-	if(!engine_handle || m_shuttingDown)
+	if(!engine_handle || IsStopping())
 		return;
 
-	m_data[m_nextData].h_headPos[FACEAPI_VERT]		= METERS_TO_CMS(head_pose.head_pos.y);
-	m_data[m_nextData].h_headPos[FACEAPI_SIDEW]		= -METERS_TO_CMS(head_pose.head_pos.x);
-	m_data[m_nextData].h_headPos[FACEAPI_DEPTH]		= METERS_TO_CMS(head_pose.head_pos.z);
-	m_data[m_nextData].h_headPos[FACEAPI_YAW]		= RAD_TO_DEG(head_pose.head_rot.y_rads);
-	m_data[m_nextData].h_headPos[FACEAPI_PITCH]		= RAD_TO_DEG(head_pose.head_rot.x_rads);
-	m_data[m_nextData].h_headPos[FACEAPI_ROLL]		= RAD_TO_DEG(head_pose.head_rot.z_rads);
+	FaceAPIData &data = GetWriteData();
 
-	m_data[m_nextData].h_confidence		= head_pose.confidence;
-	m_data[m_nextData].h_frameNum		= m_frame++;
+	data.h_headPos[FACEAPI_VERT]	= METERS_TO_CMS(head_pose.head_pos.y);
+	data.h_headPos[FACEAPI_SIDEW]	= -METERS_TO_CMS(head_pose.head_pos.x);
+	data.h_headPos[FACEAPI_DEPTH]	= METERS_TO_CMS(head_pose.head_pos.z);
+	data.h_headPos[FACEAPI_YAW]		= RAD_TO_DEG(head_pose.head_rot.y_rads);
+	data.h_headPos[FACEAPI_PITCH]	= RAD_TO_DEG(head_pose.head_rot.x_rads);
+	data.h_headPos[FACEAPI_ROLL]	= RAD_TO_DEG(head_pose.head_rot.z_rads);
 
-	m_currData = m_nextData;
-	m_nextData = (m_nextData + 1) % 3;
-}
-#endif
+	data.h_confidence	= head_pose.confidence;
+	data.h_frameNum		= video_frame.frame_num;
+	data.h_time			= ENGINE_NOW;
 
-FaceAPI* GetFaceAPI() 
-{
-	if(_faceapi == NULL)
-	{
-		_faceapi = new FaceAPI();
-		_faceapi->Init();
-	}
-	return _faceapi;
+	PublishData();
 }
+#endif
 
 FaceAPI::FaceAPI() 
 {
 	// too early to initialise the actual tracking
-	_faceapi = this;
-	m_frame = 1;
-	m_isReady = false;
+	engine_handle = NULL;
+	m_rate = 0;
+#	ifdef USE_FACEAPI_4
+	m_fetcher = NULL;
+	m_fetchFailing = false;
+#	endif
+
+	m_versionMajor = 0;
+	m_versionMinor = 0;
+	m_versionMaintenance = 0;
 }
 
-// The main function: setup a tracking engine and show a video window, then loop on the keyboard.
-void FaceAPI::Init()
+// Setup a tracking engine and (optionally) show a video window. This is run on
+// the init thread, see HeadTrackerBackend::Init
+bool FaceAPI::InitTracking()
 {
     // Log API debugging information to a file (good for tech support)
     THROW_ON_ERROR(smLoggingSetFileOutputEnable(SM_API_TRUE));
@@ -171,13 +186,15 @@ void FaceAPI::Init()
 	THROW_ON_ERROR(smAPIInternalQtGuiDisable());
     
 	// Initialize the API
-    THROW_ON_ERROR(smAPIInit());
+    FAIL_ON_ERROR(smAPIInit());
+	FAIL_ON_STOP();
 
     // Register the WDM category of cameras
-    THROW_ON_ERROR(smCameraRegisterType(SM_API_CAMERA_TYPE_WDM));
+    FAIL_ON_ERROR(smCameraRegisterType(SM_API_CAMERA_TYPE_WDM));
 
     // Create a new Head-Tracker engine that uses the camera
-    THROW_ON_ERROR(smEngineCreate(SM_API_ENGINE_LATEST_HEAD_TRACKER,&engine_handle));
+    FAIL_ON_ERROR(smEngineCreate(SM_API_ENGINE_LATEST_HEAD_TRACKER,&engine_handle));
+	FAIL_ON_STOP();
 
     // Check license for particular engine version (always ok for non-commercial license)
     const bool engine_licensed = smEngineIsLicensed(engine_handle) == SM_API_OK;
@@ -202,36 +219,48 @@ void FaceAPI::Init()
 	//smHTV2SetHeadPoseFilterLevel(engine_handle, 2);
 
 #	ifndef USE_FACEAPI_4
-	THROW_ON_ERROR(smHTRegisterHeadPoseCallback(engine_handle, 0, receiveHeadPose));
+	FAIL_ON_ERROR(smHTRegisterHeadPoseCallback(engine_handle, this, receiveHeadPose));
 #	endif
 
     // Start tracking
-    THROW_ON_ERROR(smEngineStart(engine_handle));
+    FAIL_ON_ERROR(smEngineStart(engine_handle));
+	FAIL_ON_STOP();
+
+	char model[128];
+	int framerate, resWidth, resHeight;
+	GetCameraDetails(model, sizeof(model), framerate, resWidth, resHeight);
+	m_rate = (float)framerate;
+	engine_printf("faceAPI camera: %s (%dx%d at %d fps)\n", model, resWidth, resHeight, framerate);
 
 #	ifdef USE_FACEAPI_4
 	// start up the fetcher
-	m_shuttingDown = false;
-	m_currData = 0;
-	m_nextData = 1;
-	(HANDLE)_beginthread(FaceAPI_dataFetcher, 0, (void *) 0);
+	m_fetchFailing = false;
+	m_fetcher = new FetchThread(this);
+	if(!m_fetcher->Start())
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to start the fetcher thread");
+		return false;
+	}
 #	endif
 
-	m_isReady = true;
+	return true;
 }
 
-void FaceAPI::Shutdown() 
+void FaceAPI::ShutdownTracking() 
 {
-	m_isReady = false;
-
 #	ifdef USE_FACEAPI_4
-	// wait for the fetcher thread to die
-	m_shuttingDown = true;
-	while(_faceapi_fetcher_running)
-		Sleep(100);
+	// the fetcher gives up within a frame of the stop event being set
+	if(m_fetcher)
+	{
+		m_fetcher->Join();
+		delete m_fetcher;
+		m_fetcher = NULL;
+	}
 #	endif
 
 	// Destroy engine
-    THROW_ON_ERROR(smEngineDestroy(&engine_handle));
+	if(engine_handle)
+		THROW_ON_ERROR(smEngineDestroy(&engine_handle));
 	THROW_ON_ERROR(smAPIQuit());
 }
 
@@ -247,17 +276,6 @@ void FaceAPI::RestartTracking()
 	THROW_ON_ERROR(smEngineStart(engine_handle));
 }
 
-FaceAPIData FaceAPI::GetHeadData()
-{
-	int curr = m_currData;
-	return m_data[curr];
-}
-
-float FaceAPI::GetTrackingConf()
-{
-	return m_data[m_currData].h_confidence;
-}
-
 void FaceAPI::GetCameraDetails(char *modelBuf, int bufLen, int &framerate, int &resWidth, int &resHeight)
 {
 	smCameraVideoFormat video_format;
@@ -17,70 +17,63 @@ sample programs (file: TestAppConsole.cpp).
 #ifndef FACEAPI_H
 #define FACEAPI_H
 
-#include <string>
-#include <sstream>
+#include "hal/head_tracker.h"
 
 #include "sm_api.h"
 typedef struct smEngineHandle__* smEngineHandle;
 
-// Once the faceAPI 4 has been publicly released, uncomment this line to use it
+// Both versions of the faceAPI share the same header, so only one of them can
+// be built in. Once the faceAPI 4 has been publicly released, uncomment this
+// line to use it
 //#define USE_FACEAPI_4
 
-#define FACEAPI_ROLL	0
-#define FACEAPI_YAW		1
-#define FACEAPI_PITCH	2
-#define FACEAPI_VERT	3
-#define FACEAPI_SIDEW	4
-#define FACEAPI_DEPTH	5
 
-class FaceAPIData
+// Seeing Machines' faceAPI, which tracks the head using a webcam. The v3 SDK
+// pushes each pose to a callback, whereas v4 has to be pulled from a thread
+class FaceAPI: public HeadTrackerBackend
 {
 public:
-	FaceAPIData();
+	FaceAPI();
 
-	float			h_headPos[6];
-	float			h_confidence;
-	unsigned int	h_frameNum;
-};
+	const char*		GetName() { return "faceapi"; }
+	int				GetCapabilities() { return TRACKER_ROTATION | TRACKER_POSITION | TRACKER_CONFIDENCE | TRACKER_CAMERA | TRACKER_FRAMES; }
+	float			GetNativeRate() { return m_rate; }
 
-class FaceAPI
-{
-public:
-	FaceAPI();
-	void			Init();
-	void			Shutdown();
 	void			GetVersion(int &major, int &minor, int &maintenance);
 	void			GetCameraDetails(char *modelBuf, int bufLen, int &framerate, int &resWidth, int &resHeight);
 	void			RestartTracking();
-
-	FaceAPIData		GetHeadData();		// not a halting function
-	float			GetTrackingConf();
-
-	bool			IsReady() { return m_isReady; }
 	
 #	ifdef USE_FACEAPI_4
 	bool			InternalDataFetch();
 #	else
-	void			SetData(smEngineHeadPoseData head_pose);
+	void			SetData(smEngineHeadPoseData head_pose, smCameraVideoFrame video_frame);
 #	endif
 
 protected:
-	smEngineHandle	engine_handle;
+	bool			InitTracking();
+	void			ShutdownTracking();
 
-	FaceAPIData		m_data[3];
-	int				m_currData;
-	int				m_nextData;
+	smEngineHandle	engine_handle;
 
-	bool			m_shuttingDown;
+#	ifdef USE_FACEAPI_4
+	class FetchThread: public CThread
+	{
+	public:
+		FetchThread(FaceAPI *faceAPI) : m_faceAPI(faceAPI) {}
+		int Run();
+	private:
+		FaceAPI *m_faceAPI;
+	};
+
+	FetchThread		*m_fetcher;
+	bool			m_fetchFailing;
+#	endif
 
 	int				m_versionMajor;
 	int				m_versionMinor;
 	int				m_versionMaintenance;
 
-	int				m_frame;
-	bool			m_isReady;
+	float			m_rate;
 };
 
-FaceAPI* GetFaceAPI();
-
 #endif FACEAPI_H
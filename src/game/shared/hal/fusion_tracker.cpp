@@ -0,0 +1,453 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+#include <windows.h>
+#include "tier0/threadtools.h"
+
+#include "hal/hal.h"
+#include "hal/engine_dependencies.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+ConVar hal_fusionTrackers("hal_fusionTrackers", "faceapi udp", FCVAR_ARCHIVE, "The trackers combined by the fusion tracker. The first is the reference the others are aligned to");
+ConVar hal_fusionMaxAge_s("hal_fusionMaxAge_s", "0.2", FCVAR_ARCHIVE, "How old a tracker's pose can get before the fusion stops using it", true, 0.01f, true, 1);
+
+#define FUSION_MAX_SOURCES	4
+
+// How quickly the noise estimates and the offsets to the reference follow
+// changes, per sample
+#define FUSION_NOISE_RATE	0.05f
+#define FUSION_OFFSET_RATE	0.01f
+
+// The noise assumed before there is anything to measure, and the least any
+// source is trusted to have (in degrees or centimetres, squared)
+#define FUSION_NOISE_START	1.0f
+#define FUSION_NOISE_MIN	0.0001f
+
+// How often the init checks on the trackers it is waiting for
+#define FUSION_POLL_MS		10
+
+
+// A single tracker being fused
+class FusionSource
+{
+public:
+	FusionSource() : tracker(NULL), capabilities(0), lastFrameNum(0), count(0) {}
+
+	void	Add(const FaceAPIData &data, const float *others, const float *othersNoise);
+	void	Predict(float time, float *pose);
+	bool	IsUsable(float time);
+	bool	HasChannel(int channel);
+	float	GetConfidence();
+
+	HeadTrackerBackend	*tracker;
+	int					capabilities;
+	unsigned int		lastFrameNum;
+
+	// the last two poses, so a pose can be predicted for any time
+	FaceAPIData			prev;
+	FaceAPIData			last;
+	int					count;
+
+	float				noise[6];	// the mean squared error, less that of the other trackers
+	float				offset[6];	// from this source to the reference
+};
+
+void FusionSource::Predict(float time, float *pose)
+{
+	float dt = last.h_time - prev.h_time;
+	float ahead = clamp(time - last.h_time, 0, hal_fusionMaxAge_s.GetFloat());
+
+	for(int i = 0; i < 6; i++)
+	{
+		pose[i] = last.h_headPos[i];
+		if(count > 1 && dt > 0)
+			pose[i] += (last.h_headPos[i] - prev.h_headPos[i]) / dt * ahead;
+	}
+}
+
+// The noise is measured against the other trackers fused without this one
+// (see FusionTracker::FuseOthers), as the full fused pose leans towards
+// whichever tracker already has the most weight and would make it look
+// steadier than it is. The squared error is the noise of both, so the noise of
+// the others' fusion (othersNoise) is taken back out. It includes any jitter
+// in the timestamps as well. A channel the others can't see (othersNoise < 0)
+// is left where it was
+void FusionSource::Add(const FaceAPIData &data, const float *others, const float *othersNoise)
+{
+	if(count == 0)
+	{
+		for(int i = 0; i < 6; i++)
+		{
+			noise[i] = FUSION_NOISE_START;
+			offset[i] = 0;
+		}
+	}
+	else if(data.h_confidence > 0)
+	{
+		for(int i = 0; i < 6; i++)
+		{
+			if(othersNoise[i] < 0)
+				continue;
+
+			float error = data.h_headPos[i] + offset[i] - others[i];
+			noise[i] += (error * error - othersNoise[i] - noise[i]) * FUSION_NOISE_RATE;
+			noise[i] = max(noise[i], FUSION_NOISE_MIN);
+		}
+	}
+
+	prev = last;
+	last = data;
+	lastFrameNum = data.h_frameNum;
+	count++;
+}
+
+bool FusionSource::IsUsable(float time)
+{
+	return count > 0 && last.h_confidence > 0 && time - last.h_time <= hal_fusionMaxAge_s.GetFloat();
+}
+
+bool FusionSource::HasChannel(int channel)
+{
+	bool rotation = (channel == FACEAPI_ROLL || channel == FACEAPI_YAW || channel == FACEAPI_PITCH);
+	return (capabilities & (rotation ? TRACKER_ROTATION : TRACKER_POSITION)) != 0;
+}
+
+float FusionSource::GetConfidence()
+{
+	return (capabilities & TRACKER_CONFIDENCE) ? last.h_confidence : 1.0f;
+}
+
+
+
+// Runs several trackers at once and combines them into a single pose, such
+// as a fast but noisy webcam with a slower but steadier IR tracker. A new
+// pose is fused whenever any of them publishes, so the output runs at the
+// rate of the fastest. Each pose is predicted forward to the time of the
+// newest one, then weighted by its confidence and how noisy that tracker
+// has been. Every tracker sees the head from its own position, so each is
+// aligned to the first one listed in hal_fusionTrackers
+class FusionTracker: public HeadTrackerBackend
+{
+public:
+	FusionTracker() : m_numSources(0), m_thread(NULL) {}
+
+	const char*		GetName() { return "fusion"; }
+	int				GetCapabilities() { return TRACKER_ROTATION | TRACKER_POSITION | TRACKER_CONFIDENCE | TRACKER_TIMESTAMPS; }
+	float			GetNativeRate();
+
+	void			Fuse();
+	void			Print();	// reads the fusion thread's estimates without locking
+
+protected:
+	bool			InitTracking();
+	void			ShutdownTracking();
+
+private:
+	bool			WaitForSources();
+	void			Run();
+	void			FuseOthers(int source, float time, float *pose, float *noise);
+
+	class FuseThread: public CThread
+	{
+	public:
+		FuseThread(FusionTracker *tracker) : m_tracker(tracker) {}
+		int Run() { m_tracker->Run(); return 0; }
+
+	private:
+		FusionTracker *m_tracker;
+	};
+
+	FusionSource	m_sources[FUSION_MAX_SOURCES];
+	int				m_numSources;
+
+	float			m_pose[6];	// the last fused pose
+
+	CThreadEvent	m_publishEvent;
+	FuseThread		*m_thread;
+};
+
+REGISTER_HEAD_TRACKER(FusionTracker, "fusion", "Combines the trackers listed in hal_fusionTrackers");
+
+
+float FusionTracker::GetNativeRate()
+{
+	float rate = 0;
+	for(int i = 0; i < m_numSources; i++)
+		rate = max(rate, m_sources[i].tracker->GetNativeRate());
+	return rate;
+}
+
+bool FusionTracker::InitTracking()
+{
+	char names[256];
+	Q_strncpy(names, hal_fusionTrackers.GetString(), sizeof(names));
+
+	m_numSources = 0;
+	for(char *name = strtok(names, " ,"); name && m_numSources < FUSION_MAX_SOURCES; name = strtok(NULL, " ,"))
+	{
+		HeadTrackerBackend *tracker = (Q_stricmp(name, GetName())) ? UTIL_CreateHeadTracker(name) : NULL;
+		if(!tracker)
+		{
+			engine_printf("Fusion: ignoring unknown tracker '%s'\n", name);
+			continue;
+		}
+
+		FusionSource &source = m_sources[m_numSources++];
+		source = FusionSource();
+		source.tracker = tracker;
+		source.capabilities = tracker->GetCapabilities();
+		tracker->SetPublishEvent(&m_publishEvent);
+		tracker->Init();
+	}
+
+	memset(m_pose, 0, sizeof(m_pose));
+
+	if(!WaitForSources())
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "cancelled");
+		return false;
+	}
+
+	// carry on with whichever started
+	int ready = 0;
+	for(int i = 0; i < m_numSources; i++)
+	{
+		HeadTrackerBackend *tracker = m_sources[i].tracker;
+		if(tracker->IsReady())
+			ready++;
+		else
+			engine_printf("Fusion: unable to start %s: %s\n", tracker->GetName(), tracker->GetInitError());
+	}
+
+	if(ready == 0)
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "none of '%s' started", hal_fusionTrackers.GetString());
+		return false;
+	}
+
+	m_thread = new FuseThread(this);
+	if(!m_thread->Start())
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to start the fusion thread");
+		return false;
+	}
+
+	return true;
+}
+
+// Waits for every tracker to finish starting. When cancelled this still waits
+// for them to give up, so they can all be shut down without blocking
+bool FusionTracker::WaitForSources()
+{
+	for(;;)
+	{
+		bool starting = false;
+		for(int i = 0; i < m_numSources; i++)
+		{
+			HeadTrackerBackend *tracker = m_sources[i].tracker;
+			if(tracker->GetState() == TRACKER_STARTING && !(IsStopping() && tracker->Shutdown(0)))
+				starting = true;
+		}
+
+		if(!starting)
+			return !IsStopping();
+
+		if(IsStopping())
+			ThreadSleep(FUSION_POLL_MS);
+		else
+			WaitForStop(FUSION_POLL_MS);
+	}
+}
+
+void FusionTracker::ShutdownTracking()
+{
+	if(m_thread)
+	{
+		m_thread->Join();
+		delete m_thread;
+		m_thread = NULL;
+	}
+
+	for(int i = 0; i < m_numSources; i++)
+	{
+		m_sources[i].tracker->Shutdown();
+		delete m_sources[i].tracker;
+	}
+	m_numSources = 0;
+}
+
+void FusionTracker::Run()
+{
+	HANDLE events[2] = { m_publishEvent, GetStopEvent() };
+
+	while(WaitForMultipleObjects(2, events, FALSE, INFINITE) == WAIT_OBJECT_0)
+		Fuse();
+}
+
+// Fuses every tracker but the given one at the given time, along with the
+// noise of the result (that of an inverse-variance weighted mean). A channel
+// none of the others can see is given a noise of -1. When only one other can
+// see it the noise is given as 0: the error between two trackers can't say
+// which of them is the noisy one, and splitting it on their current estimates
+// would let them drift apart, so they both carry all of it
+void FusionTracker::FuseOthers(int source, float time, float *pose, float *noise)
+{
+	float predicted[FUSION_MAX_SOURCES][6];
+	bool usable[FUSION_MAX_SOURCES];
+	for(int i = 0; i < m_numSources; i++)
+	{
+		usable[i] = (i != source && m_sources[i].IsUsable(time));
+		if(usable[i])
+			m_sources[i].Predict(time, predicted[i]);
+	}
+
+	for(int c = 0; c < 6; c++)
+	{
+		float sum = 0, weights = 0, precision = 0;
+		int count = 0;
+		for(int i = 0; i < m_numSources; i++)
+		{
+			if(!usable[i] || !m_sources[i].HasChannel(c))
+				continue;
+
+			float variance = max(m_sources[i].noise[c], FUSION_NOISE_MIN);
+			float weight = m_sources[i].GetConfidence() / variance;
+			sum += (predicted[i][c] + m_sources[i].offset[c]) * weight;
+			weights += weight;
+			precision += 1 / variance;
+			count++;
+		}
+
+		pose[c] = (count > 0) ? sum / weights : 0;
+		noise[c] = (count > 1) ? 1 / precision : ((count > 0) ? 0 : -1);
+	}
+}
+
+// The trackers without TRACKER_TIMESTAMPS (such as the faceAPI and UDP) stamp
+// their poses when they arrive, so their poses count as newer than they are
+// when picking the time to fuse for. That is no worse than using them alone
+void FusionTracker::Fuse()
+{
+	bool fresh = false;
+	float now = 0;
+
+	for(int i = 0; i < m_numSources; i++)
+	{
+		FusionSource &source = m_sources[i];
+		if(!source.tracker->IsReady())
+			continue;
+
+		FaceAPIData data = source.tracker->GetHeadData();
+		if(data.h_frameNum != source.lastFrameNum)
+		{
+			float others[6], othersNoise[6];
+			FuseOthers(i, data.h_time, others, othersNoise);
+			source.Add(data, others, othersNoise);
+			fresh = true;
+		}
+		if(source.count > 0)
+			now = max(now, source.last.h_time);
+	}
+
+	if(!fresh)
+		return;
+
+	float predicted[FUSION_MAX_SOURCES][6];
+	bool usable[FUSION_MAX_SOURCES];
+	for(int i = 0; i < m_numSources; i++)
+	{
+		usable[i] = m_sources[i].IsUsable(now);
+		if(usable[i])
+			m_sources[i].Predict(now, predicted[i]);
+	}
+
+	// learn how far each tracker is from the reference, while both can see
+	// the head
+	if(usable[0])
+	{
+		for(int i = 1; i < m_numSources; i++)
+		{
+			if(!usable[i])
+				continue;
+
+			for(int c = 0; c < 6; c++)
+			{
+				if(m_sources[0].HasChannel(c) && m_sources[i].HasChannel(c))
+					m_sources[i].offset[c] += (predicted[0][c] - predicted[i][c] - m_sources[i].offset[c]) * FUSION_OFFSET_RATE;
+			}
+		}
+	}
+
+	float confidence = 0;
+	for(int c = 0; c < 6; c++)
+	{
+		float sum = 0, weights = 0;
+		for(int i = 0; i < m_numSources; i++)
+		{
+			if(!usable[i] || !m_sources[i].HasChannel(c))
+				continue;
+
+			float weight = m_sources[i].GetConfidence() / max(m_sources[i].noise[c], FUSION_NOISE_MIN);
+			sum += (predicted[i][c] + m_sources[i].offset[c]) * weight;
+			weights += weight;
+			confidence = max(confidence, m_sources[i].GetConfidence());
+		}
+
+		// a channel nobody can see holds its last value
+		if(weights > 0)
+			m_pose[c] = sum / weights;
+	}
+
+	FaceAPIData &data = GetWriteData();
+	for(int c = 0; c < 6; c++)
+		data.h_headPos[c] = m_pose[c];
+	data.h_confidence = confidence;
+	data.h_time = now;
+	PublishData();
+}
+
+// The estimates are written by the fusion thread as the poses come in. This is
+// only for display, so like TrackerHealth it doesn't lock, and a line can mix
+// values from either side of an update
+void FusionTracker::Print()
+{
+	static const char *channels[6] = { "roll", "yaw", "pitch", "vert", "sidew", "depth" };
+
+	for(int i = 0; i < m_numSources; i++)
+	{
+		FusionSource &source = m_sources[i];
+		Msg("%s%s (%s):\n", source.tracker->GetName(), (i == 0) ? ", reference" : "", 
+				source.tracker->IsReady() ? "running" : "not running");
+
+		for(int c = 0; c < 6; c++)
+		{
+			if(source.HasChannel(c) && source.count > 0)
+				Msg("  %-6s noise %7.3f  offset %7.2f\n", channels[c], sqrt(source.noise[c]), source.offset[c]);
+		}
+	}
+}
+
+
+CON_COMMAND(hal_fusion, "Shows how the fusion tracker is weighting its trackers")
+{
+	HeadTrackerBackend *tracker = UTIL_GetHeadTracker();
+	if(!tracker || Q_stricmp(tracker->GetName(), "fusion") || !tracker->IsReady())
+	{
+		Msg("The fusion tracker is not running (see hal_tracker)\n");
+		return;
+	}
+	static_cast<FusionTracker*>(tracker)->Print();
+}
@@ -15,19 +15,32 @@ PARTICULAR PURPOSE.
 
 #include "hal/hal.h"
 #include "hal/util.h"
+#include <KeyValues.h>
+#include "filesystem.h"
 
-#define FILTER_ROLL		0
-#define FILTER_PITCH	1
-#define FILTER_YAW		2
-#define FILTER_VERT		3
-#define FILTER_SIDEW	4
-#define FILTER_LEAN		5
+#define NEUTRAL_POSE_FILE	"cfg/hal_neutral.txt"
+
+// How long quitting waits for the trackers to stop, before giving up on them
+#define TRACKER_EXIT_WAIT_MS	2000
+
+static const char *s_neutralNames[NEUTRAL_CHANNELS] = { "roll", "yaw", "pitch", "vert", "sidew" };
 
 
 HALTechnique* __hal;
 
-HALTechnique::HALTechnique() {
+static void OnTrackerChanged(IConVar *var, const char *pOldValue, float flOldValue)
+{
+	UTIL_RestartHeadTracker();
+}
+
+ConVar hal_tracker("hal_tracker", "faceapi", FCVAR_ARCHIVE, "The head tracker to use (see hal_trackers)", OnTrackerChanged);
+
+HALTechnique::HALTechnique() 
+	: m_tracker(NULL), m_trackerState(TRACKER_STOPPED), m_lastFrameNum(0), m_renderFrame(-1), m_handyOrientation(false), m_adapt(1) {
+	m_renderRotation.Init(0, 0, 0, 1);
 	__hal = this;
+	memset(m_neutral, 0, sizeof(m_neutral));
+	m_neutralKey[0] = '\0';
 }
 
 // We initialise it here, to ensure the other parts of the system have been
@@ -35,14 +48,15 @@ HALTechnique::HALTechnique() {
 
 void HALTechnique::Init()
 {
-	m_faceAPI.Init();
-
 	// Setup the filtering of the head data:
 	m_handySmoothing_auto = new TunableVar("hal_handySmoothing_auto", "-1", 0); // for increasing the smoothing during low confidence periods
 	m_leanSmoothing_auto = new TunableVar("hal_leanSmoothing_auto", "-1", 0);
 	m_smoothedConf = new MovingMeanFilter(&hal_adaptSmoothConfSample_sec);
 	m_handyScaleAuto = new TunableVar("hal_handyScale_auto", "-1", 0); // for suppressing the handycam while leaning
 
+	for(int i = 0; i < sizeof(m_outliers)/sizeof(OutlierFilter*); i++)
+		m_outliers[i] = new OutlierFilter(i);
+
 	// These are used by both the handy-cam and leaning, hence why we create them first
 	WeightedMeanOffsetFilter *meanRoll = new WeightedMeanOffsetFilter(FACEAPI_ROLL, &hal_leanRollMin_deg);
 	MeanOffsetFilter *meanYaw = new MeanOffsetFilter(FACEAPI_YAW);
@@ -50,6 +64,12 @@ void HALTechnique::Init()
 	MeanOffsetFilter *meanVert = new MeanOffsetFilter(FACEAPI_VERT);
 	MeanOffsetFilter *meanSidew = new MeanOffsetFilter(FACEAPI_SIDEW);
 
+	m_neutral[FACEAPI_ROLL]		= meanRoll;
+	m_neutral[FACEAPI_YAW]		= meanYaw;
+	m_neutral[FACEAPI_PITCH]	= meanPitch;
+	m_neutral[FACEAPI_VERT]		= meanVert;
+	m_neutral[FACEAPI_SIDEW]	= meanSidew;
+
 	// change this to alter how each aspect of the head data is filtered
 	m_filteredHeadData[FILTER_ROLL] =
 			new FadeFilter(&hal_fadingDuration_s,
@@ -106,27 +126,219 @@ void HALTechnique::Init()
 					)
 				)
 			);
+
+	// The lean as it goes into the smoothing, for the scope
+	m_leanInput =
+			new ClampFilter(-1, 1,
+				new SumFilter(
+					new NormaliseFilter(&hal_leanRollMin_deg, &hal_leanRollRange_deg, meanRoll),
+					new NormaliseFilter(&hal_leanOffsetMin_cm, &hal_leanOffsetRange_cm, meanSidew)
+				)
+			);
+
+	// Short drop-outs are held over, rather than faded straight away
+	for(int i = 0; i < sizeof(m_filteredHeadData)/sizeof(Filter*); i++)
+		m_filteredHeadData[i] = new BridgeFilter(m_filteredHeadData[i]);
+
+	// The same as the roll, pitch and yaw chains, but as a single rotation
+	m_orientation = new OrientationFilter(meanRoll, meanYaw, meanPitch, m_handySmoothing_auto, m_handyScaleAuto);
 }
 
+// A tracker that is still starting or stopping (a camera can take several
+// seconds) is left running rather than holding up the exit
 void HALTechnique::Shutdown()
 {
-	m_faceAPI.Shutdown();
+	if(m_tracker)
+	{
+		SaveNeutralPose();
+		m_retiring.AddToTail(m_tracker);
+		m_tracker = NULL;
+		m_trackerState = TRACKER_STOPPED;
+	}
+
+	float giveUp = Plat_FloatTime() + TRACKER_EXIT_WAIT_MS / 1000.0f;
+	for(int i = 0; i < m_retiring.Count(); i++)
+	{
+		unsigned int wait = (unsigned int)max(0, (int)((giveUp - Plat_FloatTime()) * 1000));
+		if(m_retiring[i]->Shutdown(wait))
+		{
+			delete m_retiring[i];
+		}
+		else
+		{
+			Warning("The head tracker (%s) is still running, leaving it behind\n", m_retiring[i]->GetName());
+			m_retiring[i]->LeaveRunning();
+		}
+	}
+	m_retiring.RemoveAll();
+}
+
+// Switches to the tracker named by hal_tracker. The old one is stopped
+// without waiting, and is kept aside until its thread has finished starting
+// and shutting it down (see RetireTrackers)
+void HALTechnique::RestartTracker()
+{
+	if(!m_tracker)
+		return;
+
+	SaveNeutralPose();
+
+	if(m_tracker->Shutdown(0))
+		delete m_tracker;
+	else
+		m_retiring.AddToTail(m_tracker);
+
+	m_tracker = NULL;
+	m_trackerState = TRACKER_STOPPED;
+	m_neutralKey[0] = '\0';
+	m_lastFrameNum = 0;
+	Reset();
+}
+
+void HALTechnique::RetireTrackers()
+{
+	for(int i = m_retiring.Count() - 1; i >= 0; i--)
+	{
+		if(m_retiring[i]->Shutdown(0))
+		{
+			delete m_retiring[i];
+			m_retiring.Remove(i);
+		}
+	}
+}
+
+// This waits for the first update, as the config (and so hal_tracker) hasn't
+// been loaded yet when the game systems are initialised
+void HALTechnique::StartTracker()
+{
+	m_tracker = UTIL_CreateHeadTracker(hal_tracker.GetString());
+	if(!m_tracker)
+	{
+		Warning("Unknown head tracker '%s' (see hal_trackers), using the faceAPI instead\n", hal_tracker.GetString());
+		m_tracker = UTIL_CreateHeadTracker("faceapi");
+	}
+
+	m_tracker->Init();
+}
+
+// The neutral head position depends on both the player and where their camera
+// sits, so the calibration is saved for each pairing. Starting from it avoids
+// the first few seconds of misfiring leans while the filters learn it again
+void HALTechnique::GetNeutralPoseKey(char *buf, int bufLen)
+{
+	char camera[128] = "unknown";
+	int framerate, resWidth, resHeight;
+	if(m_tracker && m_tracker->IsReady())
+		m_tracker->GetCameraDetails(camera, sizeof(camera), framerate, resWidth, resHeight);
+
+	ConVarRef playerName("name");
+	engine_sprintf(buf, bufLen, "%s (%s)", playerName.IsValid() ? playerName.GetString() : "unknown", camera);
+
+	// FindKey would treat these as a path
+	for(char *c = buf; *c; c++)
+	{
+		if(*c == '/' || *c == '\\')
+			*c = '_';
+	}
+}
+
+void HALTechnique::LoadNeutralPose()
+{
+	GetNeutralPoseKey(m_neutralKey, sizeof(m_neutralKey));
+
+	KeyValues *file = new KeyValues("NeutralPose");
+	if(file->LoadFromFile(filesystem, NEUTRAL_POSE_FILE, "MOD"))
+	{
+		KeyValues *pose = file->FindKey(m_neutralKey);
+		if(pose)
+		{
+			for(int i = 0; i < NEUTRAL_CHANNELS; i++)
+			{
+				KeyValues *channel = pose->FindKey(s_neutralNames[i]);
+				if(channel)
+					m_neutral[i]->SetNeutral(channel->GetFloat());
+			}
+		}
+	}
+	file->deleteThis();
+}
+
+void HALTechnique::SaveNeutralPose()
+{
+	if(!m_neutralKey[0] || !m_neutral[0]->HasNeutral())
+		return;
+
+	// keep the calibrations of the other players and cameras
+	KeyValues *file = new KeyValues("NeutralPose");
+	file->LoadFromFile(filesystem, NEUTRAL_POSE_FILE, "MOD");
+
+	KeyValues *pose = file->FindKey(m_neutralKey, true);
+	for(int i = 0; i < NEUTRAL_CHANNELS; i++)
+		pose->SetFloat(s_neutralNames[i], m_neutral[i]->GetNeutral());
+
+	file->SaveToFile(filesystem, NEUTRAL_POSE_FILE, "MOD");
+	file->deleteThis();
+}
+
+// The tracking starts up in the background, so this is where the game finds
+// out how it went
+void HALTechnique::UpdateTrackerState()
+{
+	int state = m_tracker->GetState();
+	if(state == m_trackerState)
+		return;
+
+	m_trackerState = state;
+
+	if(state == TRACKER_READY)
+	{
+		engine_printf("Head tracking started (%s)\n", m_tracker->GetName());
+		LoadNeutralPose();
+	}
+	else if(state == TRACKER_FAILED)
+	{
+		Warning("Unable to start the head tracking (%s): %s\n", m_tracker->GetName(), m_tracker->GetInitError());
+	}
 }
 
 void HALTechnique::Update()
 {
-	if(!m_faceAPI.IsReady())
+	if(m_retiring.Count())
+		RetireTrackers();
+
+	if(!m_tracker)
+		StartTracker();
+
+	UpdateTrackerState();
+
+	if(!m_tracker->IsReady())
 		return;
 
-	FaceAPIData	data = m_faceAPI.GetHeadData();
+	UpdateOrientationMode();
+
+	ProcessSample(m_tracker->GetHeadData());
+	m_renderFrame = -1;
+}
+
+// Runs a sample from the tracker through the filters and adds the result to
+// the interpolated poses. Called once per frame from Update, and again by
+// LatchPose for a sample that arrives while the frame is being built
+void HALTechnique::ProcessSample(FaceAPIData data)
+{
+	FaceAPIData	raw = data;
 
 	if(data.h_confidence > 0.0f)
 	{
+		// Single frame glitches are taken out before any of the filters see them
+		for(int i = 0; i < sizeof(m_outliers)/sizeof(OutlierFilter*); i++)
+			data.h_headPos[i] = m_outliers[i]->Update(raw);
+
 		// Update our adaptive smoothing value
 		float adapt = 1 - (data.h_confidence - hal_adaptSmoothMinConf_f.GetFloat()) / 
 				(hal_adaptSmoothMaxConf_f.GetFloat() - hal_adaptSmoothMinConf_f.GetFloat());
 		adapt = 1 + clamp(adapt, 0, 1) * hal_adaptSmoothAmount_p.GetFloat() / 100.0f;
 		adapt = m_smoothedConf->Update(adapt);
+		m_adapt = adapt;
 
 		m_handySmoothing_auto->SetValue(hal_handySmoothing_sec.GetFloat() * adapt);
 		m_leanSmoothing_auto->SetValue(hal_leanSmoothing_sec.GetFloat() * adapt);
@@ -138,36 +350,229 @@ void HALTechnique::Update()
 		//DevMsg("adapt: %6.2f, handy: %6.2f\n", adapt, m_handyScaleAuto->GetFloat());
 
 		for(int i = 0; i < sizeof(m_filteredHeadData)/sizeof(Filter*); i++)
-			m_filteredHeadData[i]->Update(data);
+		{
+			if(!IsOrientationChannel(i))
+				m_filteredHeadData[i]->Update(data);
+		}
 		//m_filteredHeadData[FILTER_ROLL]->Update(data);
+		m_leanInput->Update(data);
+
+		if(m_handyOrientation)
+			m_orientation->Update(data);
 	}
 	else
 	{
+		// Whatever the window held no longer says where the head will be
+		// when the tracker finds it again
+		for(int i = 0; i < sizeof(m_outliers)/sizeof(OutlierFilter*); i++)
+			m_outliers[i]->Reset();
+
 		for(int i = 0; i < sizeof(m_filteredHeadData)/sizeof(Filter*); i++)
-			m_filteredHeadData[i]->Update();
+		{
+			if(!IsOrientationChannel(i))
+				m_filteredHeadData[i]->Update();
+		}
+
+		if(m_handyOrientation)
+			m_orientation->Update();
+	}
+
+	// Only a new camera frame gives us a new pose to interpolate towards. The
+	// fading still moves the values while tracking is lost, so those all count
+	bool newFrame = (data.h_frameNum != m_lastFrameNum);
+	if(newFrame || data.h_confidence <= 0.0f)
+	{
+		float pose[POSE_CHANNELS];
+		Quaternion rotation;
+		GetFilteredPose(pose, rotation);
+
+		// stamped with when the camera saw it, not when we got around to it
+		m_poses.Add((newFrame && data.h_time > 0) ? data.h_time : ENGINE_NOW, pose, rotation);
+		m_lastFrameNum = data.h_frameNum;
+
+		// for the scope (see signal_scope_Source.cpp)
+		SignalSample sample;
+		sample.time			= ENGINE_NOW;
+		sample.confidence	= data.h_confidence;
+		sample.adapt		= m_adapt;
+		sample.leanInput	= m_leanInput->GetValue();
+		for(int i = 0; i < SIGNAL_RAW_CHANNELS; i++)
+			sample.raw[i] = raw.h_headPos[i];
+		for(int i = 0; i < POSE_CHANNELS; i++)
+			sample.filtered[i] = pose[i];
+		m_signals.Push(sample);
 	}
 }
 
+// Called just before the view is rendered. A sample that has come in since
+// Update is read from the tracker and filtered straight away, then the pose is
+// evaluated again for the current time and the rest of the frame uses it.
+// While tracking is lost the fading is left to Update, as there is nothing new
+// to latch. Returns false when the tracker isn't running
+bool HALTechnique::LatchPose()
+{
+	if(!m_tracker || !m_tracker->IsReady())
+		return false;
+
+	FaceAPIData data = m_tracker->GetHeadData();
+	if(data.h_frameNum != m_lastFrameNum && data.h_confidence > 0.0f)
+		ProcessSample(data);
+
+	if(hal_poseInterpolate.GetBool() && m_poses.Count() > 0)
+		m_poses.Evaluate(ENGINE_NOW - GetPoseDelay(), hal_poseExtrapolate_s.GetFloat(), m_renderPose, m_renderRotation);
+	else
+		GetFilteredPose(m_renderPose, m_renderRotation);
+
+	BuildViewOffset(m_renderPose, m_renderRotation);
+	m_renderFrame = ENGINE_FRAME;
+	return true;
+}
+
 void HALTechnique::Reset()
 {
 	for(int i = 0; i < sizeof(m_filteredHeadData)/sizeof(Filter*); i++)
 		m_filteredHeadData[i]->Reset();
+	for(int i = 0; i < sizeof(m_outliers)/sizeof(OutlierFilter*); i++)
+		m_outliers[i]->Reset();
+	m_leanInput->Reset();
+	m_orientation->Reset();
+
+	m_poses.Reset();
+	m_renderFrame = -1;
+}
+
+// The view, viewmodel and crosshair all ask for the pose during a frame, so
+// it is only evaluated once per frame to keep them in agreement
+const float* HALTechnique::GetRenderPose()
+{
+	if(m_renderFrame == ENGINE_FRAME)
+		return m_renderPose;
+
+	if(hal_poseInterpolate.GetBool() && m_poses.Count() > 0)
+	{
+		m_poses.Evaluate(ENGINE_NOW - GetPoseDelay(), hal_poseExtrapolate_s.GetFloat(), m_renderPose, m_renderRotation);
+	}
+	else
+	{
+		GetFilteredPose(m_renderPose, m_renderRotation);
+	}
+
+	BuildViewOffset(m_renderPose, m_renderRotation);
+	m_renderFrame = ENGINE_FRAME;
+	return m_renderPose;
+}
+
+// How far behind the render time the pose is evaluated. None by default, so
+// the newest pose is extrapolated (up to hal_poseExtrapolate_s) and no lag is
+// added. A delay trades that lag for always having a newer pose to
+// interpolate towards, which hides a jittery tracker better
+float HALTechnique::GetPoseDelay()
+{
+	float rate = m_tracker ? m_tracker->GetNativeRate() : 0;
+	float interval = (rate > 0) ? 1.0f / rate : m_poses.GetInterval();
+
+	// a slow or stalling tracker shouldn't hold the view back any further
+	return hal_poseDelayFrames.GetFloat() * min(interval, 0.1f);
+}
+
+// The filtered values, with the roll, pitch and yaw (and the rotation) from
+// the orientation filter when it is in use
+void HALTechnique::GetFilteredPose(float *pose, Quaternion &rotation)
+{
+	for(int i = 0; i < POSE_CHANNELS; i++)
+		pose[i] = m_filteredHeadData[i]->GetValue();
+
+	if(m_handyOrientation)
+	{
+		pose[FILTER_ROLL]	= m_orientation->GetRoll();
+		pose[FILTER_PITCH]	= m_orientation->GetPitch();
+		pose[FILTER_YAW]	= m_orientation->GetYaw();
+		rotation			= m_orientation->GetRotation();
+	}
+	else
+	{
+		rotation.Init(0, 0, 0, 1);
+	}
+}
+
+// The roll, pitch and yaw chains are skipped while the orientation filter
+// stands in for them
+bool HALTechnique::IsOrientationChannel(int filter)
+{
+	return m_handyOrientation && (filter == FILTER_ROLL || filter == FILTER_PITCH || filter == FILTER_YAW);
+}
+
+// Whichever of the chains or the orientation filter is taking over has been
+// skipped for a while, so it starts again (fading in) rather than carrying
+// on from where it was left
+void HALTechnique::UpdateOrientationMode()
+{
+	if(hal_handyOrientation.GetBool() == m_handyOrientation)
+		return;
+
+	m_handyOrientation = hal_handyOrientation.GetBool();
+
+	if(m_handyOrientation)
+	{
+		m_orientation->Reset();
+	}
+	else
+	{
+		m_filteredHeadData[FILTER_ROLL]->Reset();
+		m_filteredHeadData[FILTER_PITCH]->Reset();
+		m_filteredHeadData[FILTER_YAW]->Reset();
+	}
+
+	// the roll, pitch and yaw change meaning, so they aren't interpolated across
+	m_poses.Reset();
+}
+
+// Turns the pose into a rotation from the eye and a level offset, so the view
+// only has to do one matrix composition rather than adjusting each angle by hand
+void HALTechnique::BuildViewOffset(const float *pose, const Quaternion &rotation)
+{
+	m_viewOffset.position.Init(0, CMS_TO_SOURCE(pose[FILTER_SIDEW]), max(CMS_TO_SOURCE(pose[FILTER_VERT]), 0));
+
+	if(m_handyOrientation)
+	{
+		// straight from the orientation filter, without going back through angles
+		QuaternionMatrix(rotation, m_viewOffset.rotation);
+	}
+	else
+	{
+		// the pitch and roll are mirrored, as the camera faces the player
+		QAngle angles(-pose[FILTER_PITCH], pose[FILTER_YAW], -pose[FILTER_ROLL]);
+		AngleMatrix(angles, m_viewOffset.rotation);
+	}
+
+	float aspectRatio = engine->GetScreenAspectRatio() * 0.75f;
+	m_viewOffset.fovDelta = fabs(pose[FILTER_LEAN]) * hal_leanFOV.GetFloat() * aspectRatio;
+}
+
+const ViewOffset& HALTechnique::GetViewOffset()
+{
+	GetRenderPose();
+	return m_viewOffset;
 }
 
 CameraOffsets HALTechnique::GetCameraShake()
 {
+	const float *pose = GetRenderPose();
+
+	// close enough to the angles for the weapon, when these come from the
+	// orientation filter, and it saves turning the rotation back into angles
 	CameraOffsets offset;
-	offset.pitch	= m_filteredHeadData[FILTER_PITCH]->GetValue();
-	offset.roll		= m_filteredHeadData[FILTER_ROLL]->GetValue();
-	offset.yaw		= m_filteredHeadData[FILTER_YAW]->GetValue();
-	offset.vertOff	= m_filteredHeadData[FILTER_VERT]->GetValue();
-	offset.horOff	= m_filteredHeadData[FILTER_SIDEW]->GetValue();
+	offset.pitch	= pose[FILTER_PITCH];
+	offset.roll		= pose[FILTER_ROLL];
+	offset.yaw		= pose[FILTER_YAW];
+	offset.vertOff	= pose[FILTER_VERT];
+	offset.horOff	= pose[FILTER_SIDEW];
 	return offset;
 }
 
 float HALTechnique::GetLeanAmount()
 {
-	return m_filteredHeadData[FILTER_LEAN]->GetValue();
+	return GetRenderPose()[FILTER_LEAN];
 }
 
 float UTIL_GetLeanAmount()
@@ -180,8 +585,39 @@ CameraOffsets UTIL_GetHandycamShake()
 	return (__hal) ? __hal->GetCameraShake() : CameraOffsets();
 }
 
+ViewOffset UTIL_GetViewOffset()
+{
+	return (__hal) ? __hal->GetViewOffset() : ViewOffset();
+}
+
 void UTIL_ResetHeadPosition()
 {
 	if(__hal)
 		__hal->Reset();
+}
+
+bool UTIL_LatchHeadPose()
+{
+	return (__hal) ? __hal->LatchPose() : false;
+}
+
+HeadTrackerBackend* UTIL_GetHeadTracker()
+{
+	return (__hal) ? __hal->GetTracker() : NULL;
+}
+
+void UTIL_RestartHeadTracker()
+{
+	if(__hal)
+		__hal->RestartTracker();
+}
+
+CON_COMMAND(hal_trackerRestart, "Stops the head tracker and starts it again (also done when hal_tracker changes)")
+{
+	UTIL_RestartHeadTracker();
+}
+
+SignalRing* UTIL_GetSignalRing()
+{
+	return (__hal) ? __hal->GetSignalRing() : NULL;
 }
\ No newline at end of file
@@ -17,7 +17,21 @@ PARTICULAR PURPOSE.
 
 #include "hal/data_filtering.h"
 #include "hal/engine_dependencies.h"
-#include "hal/faceapi.h"
+#include "hal/head_tracker.h"
+#include "hal/orientation_filter.h"
+#include "hal/pose_interpolation.h"
+#include "hal/signal_scope.h"
+#include "mathlib/mathlib.h"
+
+#define FILTER_ROLL		0
+#define FILTER_PITCH	1
+#define FILTER_YAW		2
+#define FILTER_VERT		3
+#define FILTER_SIDEW	4
+#define FILTER_LEAN		5	// these also index the POSE_CHANNELS
+
+// the head data channels (FACEAPI_ROLL to FACEAPI_SIDEW) with a neutral position
+#define NEUTRAL_CHANNELS	5
 
 
 class CameraOffsets
@@ -34,6 +48,19 @@ public:
 };
 
 
+// The camera offsets (and the lean zoom). The rotation is applied in eye
+// space, while the position stays level so looking up or down doesn't tip it
+class ViewOffset
+{
+public:
+	ViewOffset() : position(0, 0, 0), fovDelta(0) { SetIdentityMatrix(rotation); };
+
+	matrix3x4_t rotation;
+	Vector position;	// in the yaw only frame: x is forward, y is left and z is up
+	float fovDelta;
+};
+
+
 
 class HALTechnique
 {
@@ -41,24 +68,70 @@ public:
 	HALTechnique();
 	void				Init();
 	void				Shutdown();
+	void				RestartTracker();
 	void				Update();
+	bool				LatchPose();
 	float				GetLeanAmount();
 	CameraOffsets		GetCameraShake();
+	const ViewOffset&	GetViewOffset();
 	void				Reset();
+	SignalRing*			GetSignalRing() { return &m_signals; }
+	HeadTrackerBackend*	GetTracker() { return m_tracker; }
 
 private:
+	void				GetFilteredPose(float *pose, Quaternion &rotation);
+	bool				IsOrientationChannel(int filter);
+	void				UpdateOrientationMode();
+	void				ProcessSample(FaceAPIData data);
+	const float*		GetRenderPose();
+	float				GetPoseDelay();
+	void				BuildViewOffset(const float *pose, const Quaternion &rotation);
+	void				StartTracker();
+	void				RetireTrackers();
+	void				UpdateTrackerState();
+	void				GetNeutralPoseKey(char *buf, int bufLen);
+	void				LoadNeutralPose();
+	void				SaveNeutralPose();
+
 	MovingMeanFilter		*m_smoothedConf;
+	OutlierFilter		*m_outliers[6];		// indexed by FACEAPI_*, ahead of everything else
 	Filter				*m_filteredHeadData[6];
-	FaceAPI				m_faceAPI;
+	OrientationFilter	*m_orientation;		// replaces the roll, pitch and yaw chains
+	Filter				*m_leanInput;		// the lean before its smoothing, for the scope
+	HeadTrackerBackend	*m_tracker;
+	int					m_trackerState;
+
+	// stopped trackers whose threads haven't finished, see RestartTracker
+	CUtlVector<HeadTrackerBackend*>	m_retiring;
 
 	TunableVar			*m_handySmoothing_auto;
 	TunableVar			*m_leanSmoothing_auto;
 	TunableVar			*m_handyScaleAuto;
+
+	// the neutral head position, indexed by FACEAPI_*
+	MeanOffsetFilter	*m_neutral[NEUTRAL_CHANNELS];
+	char				m_neutralKey[256];
+
+	// the filtered poses, as used by each rendered frame
+	PoseInterpolator	m_poses;
+	unsigned int		m_lastFrameNum;
+	float				m_renderPose[POSE_CHANNELS];
+	Quaternion			m_renderRotation;
+	int					m_renderFrame;
+	bool				m_handyOrientation;	// as of the last update, see UpdateOrientationMode
+	ViewOffset			m_viewOffset;
+
+	float				m_adapt;
+	SignalRing			m_signals;
 };
 
 float			UTIL_GetLeanAmount();
 CameraOffsets	UTIL_GetHandycamShake();
+ViewOffset		UTIL_GetViewOffset();
 void			UTIL_ResetHeadPosition();
+bool			UTIL_LatchHeadPose();
+HeadTrackerBackend*	UTIL_GetHeadTracker();
+void			UTIL_RestartHeadTracker();
 
 
 #endif
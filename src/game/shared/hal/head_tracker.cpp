@@ -0,0 +1,226 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+
+#include "hal/head_tracker.h"
+#include "hal/shm_tracker.h"
+#include "hal/engine_dependencies.h"
+#include "hal/data_filtering.h"
+#include "tier0/threadtools.h"
+
+// set in m_exchange when it holds data the game has not seen yet
+#define EXCHANGE_FRESH	0x4
+#define EXCHANGE_INDEX	0x3
+
+
+HeadTrackerRegistration *HeadTrackerRegistration::s_first = NULL;
+
+
+FaceAPIData::FaceAPIData()
+{
+	h_headPos[FACEAPI_ROLL] = 0.0f;
+	h_headPos[FACEAPI_PITCH] = 0.0f;
+	h_headPos[FACEAPI_YAW] = 0.0f;
+	h_headPos[FACEAPI_VERT] = 0.0f;
+	h_headPos[FACEAPI_SIDEW] = 0.0f;
+	h_headPos[FACEAPI_DEPTH] = 0.0f;
+
+	h_confidence = 0.0f;
+	h_frameNum = 0;
+	h_time = 0.0f;
+}
+
+// The other trackers follow the faceAPI, which has x to the camera's right
+void UTIL_SetHeadPose(FaceAPIData &data, const double *pose)
+{
+	data.h_headPos[FACEAPI_SIDEW]	= -pose[HEADPOSE_X];
+	data.h_headPos[FACEAPI_VERT]	= pose[HEADPOSE_Y];
+	data.h_headPos[FACEAPI_DEPTH]	= pose[HEADPOSE_Z];
+	data.h_headPos[FACEAPI_YAW]		= pose[HEADPOSE_YAW];
+	data.h_headPos[FACEAPI_PITCH]	= pose[HEADPOSE_PITCH];
+	data.h_headPos[FACEAPI_ROLL]	= pose[HEADPOSE_ROLL];
+}
+
+
+
+// HeadTrackerBackend
+
+class HeadTrackerThread: public CThread
+{
+public:
+	HeadTrackerThread(HeadTrackerBackend *tracker) : m_tracker(tracker) {}
+
+	int Run()
+	{
+		return m_tracker->RunTracking() ? 0 : 1;
+	}
+
+private:
+	HeadTrackerBackend *m_tracker;
+};
+
+HeadTrackerBackend::HeadTrackerBackend()
+	: m_stopEvent(true)
+{
+	m_writeData = 0;
+	m_exchange = 1;
+	m_readData = 2;
+	m_frame = 1;
+
+	m_capabilities = 0;
+	m_publishEvent = NULL;
+	m_thread = NULL;
+	m_state = TRACKER_STOPPED;
+	m_stopping = 0;
+	m_initError[0] = '\0';
+}
+
+HeadTrackerBackend::~HeadTrackerBackend()
+{
+	Assert(!m_thread);
+}
+
+// Waking a camera up can hold up the game for several seconds, so every
+// tracker is started on its own thread. Until it is done IsReady returns
+// false and the game carries on without any head data
+void HeadTrackerBackend::Init()
+{
+	if(m_thread)
+		return;
+
+	m_capabilities = GetCapabilities();
+	m_health.Reset();
+	m_stopEvent.Reset();
+	m_stopping = 0;
+
+	m_state = TRACKER_STARTING;
+	m_thread = new HeadTrackerThread(this);
+	if(!m_thread->Start())
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to start the init thread");
+		ThreadInterlockedExchange(&m_state, TRACKER_FAILED);
+	}
+}
+
+// Shutting a camera down can take as long as starting it, so that is done on
+// the same thread once the tracker is told to stop
+bool HeadTrackerBackend::RunTracking()
+{
+	bool ok = InitTracking();
+	ThreadInterlockedExchange(&m_state, ok ? TRACKER_READY : TRACKER_FAILED);
+
+	if(ok)
+		m_stopEvent.Wait();
+
+	ShutdownTracking();
+	return ok;
+}
+
+bool HeadTrackerBackend::Shutdown(unsigned timeoutMs)
+{
+	if(!m_thread)
+		return true;
+
+	// wakes up any waiting threads, including an init that can give up early
+	ThreadInterlockedExchange(&m_stopping, 1);
+	m_stopEvent.Set();
+
+	if(m_thread->IsAlive() && !m_thread->Join(timeoutMs))
+		return false;
+
+	delete m_thread;
+	m_thread = NULL;
+
+	m_state = TRACKER_STOPPED;
+	return true;
+}
+
+// The tracker's thread is still running code from this module, so the module
+// is pinned to stop it being unloaded from under the thread. The process
+// exiting ends the thread instead
+void HeadTrackerBackend::LeaveRunning()
+{
+	HMODULE module;
+	GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN, 
+			(LPCTSTR)&UTIL_SetHeadPose, &module);
+}
+
+// Called by the tracking thread once GetWriteData() has been filled
+void HeadTrackerBackend::PublishData()
+{
+	bool hasFrameNumbers = (m_capabilities & TRACKER_FRAMES) != 0;
+	if(!hasFrameNumbers)
+		m_data[m_writeData].h_frameNum = m_frame++;
+
+	m_health.Update(m_data[m_writeData], ENGINE_NOW, hasFrameNumbers, hal_adaptSmoothMinConf_f.GetFloat());
+
+	long prev = ThreadInterlockedExchange(&m_exchange, m_writeData | EXCHANGE_FRESH);
+	m_writeData = prev & EXCHANGE_INDEX;
+
+	if(m_publishEvent)
+		m_publishEvent->Set();
+}
+
+FaceAPIData HeadTrackerBackend::GetHeadData()
+{
+	if(m_exchange & EXCHANGE_FRESH)
+	{
+		long prev = ThreadInterlockedExchange(&m_exchange, m_readData);
+		m_readData = prev & EXCHANGE_INDEX;
+	}
+	return m_data[m_readData];
+}
+
+float HeadTrackerBackend::GetTrackingConf()
+{
+	return m_data[m_readData].h_confidence;
+}
+
+void HeadTrackerBackend::GetCameraDetails(char *modelBuf, int bufLen, int &framerate, int &resWidth, int &resHeight)
+{
+	engine_sprintf(modelBuf, bufLen, "%s", GetName());
+	framerate = (int)GetNativeRate();
+	resWidth = 0;
+	resHeight = 0;
+}
+
+
+
+// Registration
+
+HeadTrackerRegistration::HeadTrackerRegistration(const char *name, const char *description, HeadTrackerFactory factory)
+	: m_name(name), m_description(description), m_factory(factory)
+{
+	m_next = s_first;
+	s_first = this;
+}
+
+HeadTrackerBackend* UTIL_CreateHeadTracker(const char *name)
+{
+	for(HeadTrackerRegistration *reg = HeadTrackerRegistration::s_first; reg; reg = reg->m_next)
+	{
+		if(!Q_stricmp(reg->m_name, name))
+			return reg->m_factory();
+	}
+	return NULL;
+}
+
+CON_COMMAND(hal_trackers, "Lists the available head trackers")
+{
+	for(HeadTrackerRegistration *reg = HeadTrackerRegistration::s_first; reg; reg = reg->m_next)
+	{
+		Msg("%s%-10s %s\n", Q_stricmp(reg->m_name, hal_tracker.GetString()) ? "  " : "* ", 
+			reg->m_name, reg->m_description);
+	}
+}
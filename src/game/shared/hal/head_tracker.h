@@ -0,0 +1,176 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_HEAD_TRACKER_H
+#define HAL_HEAD_TRACKER_H
+
+// The head data channels. These kept their original names from when the
+// faceAPI was the only tracker
+#define FACEAPI_ROLL	0
+#define FACEAPI_YAW		1
+#define FACEAPI_PITCH	2
+#define FACEAPI_VERT	3
+#define FACEAPI_SIDEW	4
+#define FACEAPI_DEPTH	5
+
+// The tracking is started on its own thread (see HeadTrackerBackend::Init)
+#define TRACKER_STOPPED		0
+#define TRACKER_STARTING	1
+#define TRACKER_READY		2
+#define TRACKER_FAILED		3
+
+// What a backend can provide
+#define TRACKER_ROTATION	(1<<0)	// roll, yaw and pitch
+#define TRACKER_POSITION	(1<<1)	// vert, sidew and depth
+#define TRACKER_CONFIDENCE	(1<<2)	// otherwise the confidence is 1 while tracking
+#define TRACKER_TIMESTAMPS	(1<<3)	// h_time is the capture time rather than the arrival time
+#define TRACKER_CAMERA		(1<<4)	// GetCameraDetails returns a real device
+#define TRACKER_FRAMES		(1<<5)	// h_frameNum comes from the source, so any gaps are dropped frames
+
+#include "hal/tracker_health.h"
+#include "tier0/threadtools.h"
+
+class ConVar;
+
+
+// A single head pose. Angles are in degrees and distances in centimetres, as
+// seen from the camera
+class FaceAPIData
+{
+public:
+	FaceAPIData();
+
+	float			h_headPos[6];
+	float			h_confidence;
+	unsigned int	h_frameNum;		// increases with every new sample, see TRACKER_FRAMES
+	float			h_time;			// in ENGINE_NOW seconds, see TRACKER_TIMESTAMPS
+};
+
+
+// The base of every tracker. A backend only has to start itself up and then
+// publish each new pose from whichever thread it likes: the game picks up the
+// newest one without either side waiting on the other.
+//
+// Any thread a backend starts should wait with WaitForStop (or on
+// GetStopEvent) rather than sleeping, so that it stops as soon as it is asked
+// to. Stopping or switching trackers then never holds up the game.
+//
+// Backends register themselves by name with REGISTER_HEAD_TRACKER, and the
+// one used is chosen with hal_tracker
+class HeadTrackerBackend
+{
+public:
+	HeadTrackerBackend();
+	virtual ~HeadTrackerBackend();
+
+	virtual const char*	GetName() = 0;
+	virtual int			GetCapabilities() = 0;
+	virtual float		GetNativeRate() = 0;	// samples per second, 0 if unknown
+
+	virtual void		GetCameraDetails(char *modelBuf, int bufLen, int &framerate, int &resWidth, int &resHeight);
+	virtual void		RestartTracking() {}
+
+	void				Init();			// returns straight away, see GetState
+
+	// Stops the tracker, waiting up to the given time for its thread to
+	// finish starting up and then shutting down. Returns false if it is still
+	// running, in which case it has been told to stop and Shutdown should be
+	// called again later (or LeaveRunning, at exit)
+	bool				Shutdown(unsigned timeoutMs = TT_INFINITE);
+	void				LeaveRunning();
+	bool				RunTracking();	// called from the tracker's thread
+
+	FaceAPIData			GetHeadData();	// not a halting function
+	float				GetTrackingConf();
+
+	bool				IsReady() { return m_state == TRACKER_READY; }
+	int					GetState() { return m_state; }
+	const char*			GetInitError() { return m_initError; }
+	const TrackerHealth& GetHealth() { return m_health; }
+
+	// Set after every new pose, for trackers built on top of other trackers
+	// (see fusion_tracker.cpp). Must be set before Init
+	void				SetPublishEvent(CThreadEvent *event) { m_publishEvent = event; }
+
+protected:
+	// Run on the init thread. Any failure should be described in m_initError
+	virtual bool		InitTracking() = 0;
+	virtual void		ShutdownTracking() = 0;
+
+	// The tracking thread fills in GetWriteData() and then publishes it
+	FaceAPIData&		GetWriteData() { return m_data[m_writeData]; }
+	void				PublishData();
+
+	// Returns true, straight away, once the tracker is being shut down. The
+	// event is only for blocking waits: IsStopping reads a flag, so it is
+	// cheap enough for a spin loop
+	bool				WaitForStop(unsigned timeoutMs) { return m_stopEvent.Wait(timeoutMs); }
+	bool				IsStopping() { return m_stopping != 0; }
+	CThreadEvent&		GetStopEvent() { return m_stopEvent; }
+
+	char				m_initError[256];
+
+private:
+	// A triple buffer: the tracking thread fills m_data[m_writeData] and then
+	// swaps it with the one in m_exchange. The game does the reverse to pick
+	// up the newest one
+	FaceAPIData			m_data[3];
+	int					m_writeData;
+	int					m_readData;
+	volatile long		m_exchange;
+	unsigned int		m_frame;
+
+	int					m_capabilities;
+	TrackerHealth		m_health;
+
+	// Starting and stopping a camera can take several seconds, so both are
+	// done off the main thread. m_state is only changed once the thread is
+	// done with it
+	CThread				*m_thread;
+	volatile long		m_state;
+
+	CThreadEvent		m_stopEvent;
+	volatile long		m_stopping;
+	CThreadEvent		*m_publishEvent;
+};
+
+
+typedef HeadTrackerBackend* (*HeadTrackerFactory)();
+
+class HeadTrackerRegistration
+{
+public:
+	HeadTrackerRegistration(const char *name, const char *description, HeadTrackerFactory factory);
+
+	const char					*m_name;
+	const char					*m_description;
+	HeadTrackerFactory			m_factory;
+	HeadTrackerRegistration		*m_next;
+
+	static HeadTrackerRegistration *s_first;
+};
+
+#define REGISTER_HEAD_TRACKER(className, name, description) \
+	static HeadTrackerBackend* Create_##className() { return new className(); } \
+	static HeadTrackerRegistration s_##className##_registration(name, description, Create_##className);
+
+extern ConVar hal_tracker;
+
+// Fills in the head position from the common 6 x double layout: x, y, z (cm)
+// then yaw, pitch and roll (degrees). See HEADPOSE_* in shm_tracker.h
+void UTIL_SetHeadPose(FaceAPIData &data, const double *pose);
+
+// Returns NULL if there is no backend by that name
+HeadTrackerBackend* UTIL_CreateHeadTracker(const char *name);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+// Free of the engine (no cbase.h), so it also builds into hal_leanbench
+
+#include <math.h>
+
+#include "hal/lean_solver.h"
+#include "hal/util.h"
+
+
+float LeanSolver::Prepare(LeanState &state, float amount)
+{
+	amount *= -1; // make our right and Source's right consistent
+
+	float diff = amount - state.leanAmount;
+	state.leanAmount = amount;
+
+	float movementAmount = METERS_TO_SOURCE(diff) * LEANSIZE_IN_VIRTUAL_METERS;
+
+	if(movementAmount == 0.0f && amount == 0.0f)
+	{
+		state.reserve = 0.0f;
+	}
+
+	// example: move reserve => move reserve
+	//			  30     -40       0     -10
+	//			  30     -20      10       0
+	//            30      10       0      40
+	//			 -30      40       0      10
+	//			 -30      20     -10       0
+	//           -30     -10       0     -40
+	if(state.reserve != 0.0f)
+	{
+		if(movementAmount/state.reserve < 0)
+		{
+			// might need to absorb some movement if obsticles are involved
+			float newReserve = state.reserve + movementAmount;
+			movementAmount = 0.0f;
+
+			if(newReserve/state.reserve < 0.0f)
+			{
+				// exceeded how much we had in reserve
+				movementAmount = newReserve;
+				newReserve = 0.0f;
+			}
+			state.reserve = newReserve;
+		}
+	}
+
+	return movementAmount;
+}
+
+void LeanSolver::Resolve(ILeanWorld *world, const Vector &origin, const Vector &right, float movementAmount, 
+						 float &fraction, Vector &offset)
+{
+	Vector hullMin = HullMin();
+	Vector hullMax = HullMax();
+
+	// we try to rise up as much as we sidestep in case of a slope
+	// we don't use pUp, as this is based on the looking angle
+	Vector rise		= Vector(0,0,1)	* fabs(movementAmount); 
+	Vector sidestep	= right			* movementAmount;
+
+	fraction = world->TraceHull(origin, origin + rise + sidestep, hullMin, hullMax);
+
+	sidestep	*= fraction; // amount of movement we can actually make
+	rise		*= fraction;
+
+	float stepDown = world->TraceHull(
+			origin + sidestep + rise,
+			origin + sidestep - rise, // allow for stepping down
+			hullMin, 
+			hullMax);
+
+	rise *= 1.0f - 2 * stepDown;
+
+	offset = sidestep + rise;
+}
+
+void LeanSolver::Apply(LeanState &state, float movementAmount, float fraction)
+{
+	state.reserve += (1.0f - fraction) * movementAmount; // note how much we did not move
+}
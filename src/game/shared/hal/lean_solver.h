@@ -0,0 +1,63 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_LEAN_SOLVER_H
+#define HAL_LEAN_SOLVER_H
+
+#include "mathlib/vector.h"
+
+#define LEANSIZE_IN_VIRTUAL_METERS		1
+#define LEAN_PLAYER_SIZE				32
+#define LEAN_PLAYER_HEIGHT				72
+
+
+// The collision queries made by the lean. The players use the engine's traces
+// (player_lean_Source.cpp), while the bench uses synthetic geometry
+// (utils/hal_leanbench)
+class ILeanWorld
+{
+public:
+	// Sweeps the hull from start to end and returns the fraction travelled
+	virtual float	TraceHull(const Vector &start, const Vector &end, const Vector &hullMin, const Vector &hullMax) = 0;
+};
+
+
+class LeanState
+{
+public:
+	LeanState()
+		: leanAmount(0), reserve(0) {};
+
+	float	leanAmount;
+	float	reserve;
+};
+
+
+// The lean itself, free of any engine types. A lean is made in three steps:
+//
+//	Prepare	- updates the reserve and returns how far to move (0 for no movement)
+//	Resolve	- works out how far we can actually move, using the world
+//	Apply	- notes how much we did not move
+class LeanSolver
+{
+public:
+	static float	Prepare(LeanState &state, float amount);
+	static void		Resolve(ILeanWorld *world, const Vector &origin, const Vector &right, float movementAmount, 
+							float &fraction, Vector &offset);
+	static void		Apply(LeanState &state, float movementAmount, float fraction);
+
+	static Vector	HullMin() { return Vector(-LEAN_PLAYER_SIZE/2, -LEAN_PLAYER_SIZE/2, 0); }
+	static Vector	HullMax() { return Vector( LEAN_PLAYER_SIZE/2,  LEAN_PLAYER_SIZE/2, LEAN_PLAYER_HEIGHT); }
+};
+
+#endif
@@ -0,0 +1,87 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+#include "igamesystem.h"
+#include "player.h"
+#include "vstdlib/jobthread.h"
+
+#include "hal/player_lean.h"
+
+// Below this many leans it's not worth waking up the thread pool
+#define LEAN_STAGE_MIN_PARALLEL 4
+
+ConVar hal_leanParallel("hal_leanParallel", "1", 0, 
+		"Resolve the leans of all the players together once per tick, using the thread pool (multiplayer only)");
+
+
+// Gathers the leans queued by the players during their commands, resolves the
+// collision part of them in parallel and then applies the results in order.
+// Only the last command of each player's tick is queued (see RunLean), so each
+// command still moves from a leaned origin. The traces only read the world, so
+// the results match the serial path except that each player sees the others
+// before their own last lean. Where that changes the outcome, the client's
+// prediction is corrected through the networked lean state and origin, just
+// as for any other movement the server disagrees with.
+
+class LeanStage : public CAutoGameSystemPerFrame
+{
+public:
+	LeanStage( char const *name = NULL ) : CAutoGameSystemPerFrame( name ) {}
+	void FrameUpdatePostEntityThink();
+
+private:
+	CUtlVector<LeanRequest> m_requests;
+};
+
+// Any lean still queued is made here, even if the stage has since been turned
+// off, so that none are left waiting for the player's next command
+
+void LeanStage::FrameUpdatePostEntityThink()
+{
+	m_requests.RemoveAll();
+
+	for(int i = 1; i <= gpGlobals->maxClients; i++)
+	{
+		CBasePlayer *pPlayer = UTIL_PlayerByIndex(i);
+		float amount;
+
+		if(!pPlayer || !pPlayer->TakeQueuedLean(amount))
+			continue;
+
+		LeanRequest request;
+		if(pPlayer->PrepareLean(amount, request))
+			m_requests.AddToTail(request);
+	}
+
+	if(UTIL_IsLeanStageActive() && m_requests.Count() >= LEAN_STAGE_MIN_PARALLEL)
+	{
+		ParallelProcess(m_requests.Base(), m_requests.Count(), &UTIL_ResolveLean);
+	}
+	else
+	{
+		for(int i = 0; i < m_requests.Count(); i++)
+			UTIL_ResolveLean(m_requests[i]);
+	}
+
+	for(int i = 0; i < m_requests.Count(); i++)
+		m_requests[i].player->ApplyLean(m_requests[i]);
+}
+
+LeanStage leanStage("LeanStage");
+
+
+bool UTIL_IsLeanStageActive()
+{
+	return hal_leanParallel.GetBool() && gpGlobals->maxClients > 1;
+}
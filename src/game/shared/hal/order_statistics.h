@@ -0,0 +1,194 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_ORDER_STATISTICS_H
+#define HAL_ORDER_STATISTICS_H
+
+// The most values that can be held at once
+#define ORDER_STATISTICS_SIZE	64
+
+#define ORDER_STATISTICS_NONE	-1
+
+
+// A treap, with the size of each subtree, over a fixed pool of nodes. This
+// gives the rolling median and quartiles of OutlierFilter in O(log n) for
+// each sample: a sample is inserted, the oldest removed and the ranks picked
+// out, without sorting the window again.
+//
+// Equal values are told apart by an id (such as the sample number), so a
+// value can be removed without touching its duplicates
+class OrderStatistics
+{
+public:
+	OrderStatistics() { Clear(); }
+
+	void Clear()
+	{
+		m_root = ORDER_STATISTICS_NONE;
+		m_free = 0;
+		for(int i = 0; i < ORDER_STATISTICS_SIZE; i++)
+			m_nodes[i].right = i + 1;
+		m_nodes[ORDER_STATISTICS_SIZE - 1].right = ORDER_STATISTICS_NONE;
+		m_seed = 0x9E3779B9;
+	}
+
+	int Count() const { return Size(m_root); }
+
+	// Does nothing once full
+	void Insert(float value, unsigned int id)
+	{
+		if(m_free == ORDER_STATISTICS_NONE)
+			return;
+
+		int node = m_free;
+		m_free = m_nodes[node].right;
+
+		// xorshift, so the priorities (and the shape of the tree) are random
+		m_seed ^= m_seed << 13;
+		m_seed ^= m_seed >> 17;
+		m_seed ^= m_seed << 5;
+
+		m_nodes[node].value		= value;
+		m_nodes[node].id		= id;
+		m_nodes[node].priority	= m_seed;
+		m_nodes[node].size		= 1;
+		m_nodes[node].left		= ORDER_STATISTICS_NONE;
+		m_nodes[node].right		= ORDER_STATISTICS_NONE;
+
+		int less, more;
+		Split(m_root, value, id, less, more);
+		m_root = Merge(Merge(less, node), more);
+	}
+
+	void Remove(float value, unsigned int id)
+	{
+		m_root = Remove(m_root, value, id);
+	}
+
+	// 0 is the smallest. The rank must be less than Count()
+	float Select(int rank) const
+	{
+		int node = m_root;
+		while(node != ORDER_STATISTICS_NONE)
+		{
+			int leftSize = Size(m_nodes[node].left);
+			if(rank < leftSize)
+			{
+				node = m_nodes[node].left;
+			}
+			else if(rank == leftSize)
+			{
+				return m_nodes[node].value;
+			}
+			else
+			{
+				rank -= leftSize + 1;
+				node = m_nodes[node].right;
+			}
+		}
+		return 0.0f;
+	}
+
+private:
+	struct Node
+	{
+		float			value;
+		unsigned int	id;
+		unsigned int	priority;
+		int				size;
+		int				left;
+		int				right;
+	};
+
+	int Size(int node) const { return (node == ORDER_STATISTICS_NONE) ? 0 : m_nodes[node].size; }
+
+	void UpdateSize(int node)
+	{
+		m_nodes[node].size = 1 + Size(m_nodes[node].left) + Size(m_nodes[node].right);
+	}
+
+	bool IsLess(int node, float value, unsigned int id) const
+	{
+		return m_nodes[node].value < value || (m_nodes[node].value == value && m_nodes[node].id < id);
+	}
+
+	// Into the nodes before (value, id) and the rest
+	void Split(int node, float value, unsigned int id, int &less, int &more)
+	{
+		if(node == ORDER_STATISTICS_NONE)
+		{
+			less = more = ORDER_STATISTICS_NONE;
+		}
+		else if(IsLess(node, value, id))
+		{
+			Split(m_nodes[node].right, value, id, m_nodes[node].right, more);
+			less = node;
+			UpdateSize(node);
+		}
+		else
+		{
+			Split(m_nodes[node].left, value, id, less, m_nodes[node].left);
+			more = node;
+			UpdateSize(node);
+		}
+	}
+
+	// Every node in less must come before every node in more
+	int Merge(int less, int more)
+	{
+		if(less == ORDER_STATISTICS_NONE)
+			return more;
+		if(more == ORDER_STATISTICS_NONE)
+			return less;
+
+		if(m_nodes[less].priority > m_nodes[more].priority)
+		{
+			m_nodes[less].right = Merge(m_nodes[less].right, more);
+			UpdateSize(less);
+			return less;
+		}
+
+		m_nodes[more].left = Merge(less, m_nodes[more].left);
+		UpdateSize(more);
+		return more;
+	}
+
+	int Remove(int node, float value, unsigned int id)
+	{
+		if(node == ORDER_STATISTICS_NONE)
+			return node;
+
+		if(m_nodes[node].value == value && m_nodes[node].id == id)
+		{
+			int merged = Merge(m_nodes[node].left, m_nodes[node].right);
+			m_nodes[node].right = m_free;
+			m_free = node;
+			return merged;
+		}
+
+		if(IsLess(node, value, id))
+			m_nodes[node].right = Remove(m_nodes[node].right, value, id);
+		else
+			m_nodes[node].left = Remove(m_nodes[node].left, value, id);
+
+		UpdateSize(node);
+		return node;
+	}
+
+	Node			m_nodes[ORDER_STATISTICS_SIZE];
+	int				m_root;
+	int				m_free;
+	unsigned int	m_seed;
+};
+
+#endif
@@ -0,0 +1,188 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+
+#include "hal/orientation_filter.h"
+#include "hal/util.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+
+// In view space the roll is about x, the pitch about y and the yaw about z.
+// The pitch and roll are mirrored, as the camera faces the player (the same
+// as HALTechnique::BuildViewOffset)
+
+static void AnglesToQuaternion(float roll, float yaw, float pitch, Quaternion &q)
+{
+	AngleQuaternion(QAngle(-pitch, yaw, -roll), q);
+}
+
+void UTIL_QuaternionToRotation(const Quaternion &q, Vector &rotation)
+{
+	// the shorter way round
+	float sign = (q.w < 0) ? -1.0f : 1.0f;
+	Vector axis(q.x * sign, q.y * sign, q.z * sign);
+
+	float sinHalf = axis.Length();
+	if(sinHalf < 1e-6f)
+	{
+		rotation = axis * RAD2DEG(2.0f);
+		return;
+	}
+
+	float angle = 2.0f * atan2(sinHalf, q.w * sign);
+	rotation = axis * (RAD2DEG(angle) / sinHalf);
+}
+
+void UTIL_RotationToQuaternion(const Vector &rotation, Quaternion &q)
+{
+	float angle = DEG2RAD(rotation.Length());
+	if(angle < 1e-6f)
+	{
+		q.Init(DEG2RAD(rotation.x) * 0.5f, DEG2RAD(rotation.y) * 0.5f, DEG2RAD(rotation.z) * 0.5f, 1.0f);
+		QuaternionNormalize(q);
+		return;
+	}
+
+	float scale = sin(angle * 0.5f) / rotation.Length();
+	q.Init(rotation.x * scale, rotation.y * scale, rotation.z * scale, cos(angle * 0.5f));
+}
+
+// The LimitFilter's ease out, for a limit of 1
+static float EaseOutLimit(float value)
+{
+	float range = 1 / 1.5f;
+	float x = min(1.5f, value / range);
+	x = x/3 + 0.5f;
+	return (6*x*x - 4*x*x*x - 1) * range;
+}
+
+
+// The fade only needs to know whether there is any tracking
+class PresenceFilter: public Filter
+{
+public:
+	PresenceFilter() : Filter((Filter*)NULL) {}
+
+	float Update(FaceAPIData headData) { m_pValue = 1.0f; return m_pValue; }
+	virtual char* GetClass() { return "PresenceFilter"; }
+};
+
+
+OrientationFilter::OrientationFilter(MeanOffsetFilter *neutralRoll, MeanOffsetFilter *neutralYaw, MeanOffsetFilter *neutralPitch,
+		TunableVar *smoothing, TunableVar *scale)
+	: m_smoothing(smoothing), m_scale(scale)
+{
+	m_neutral[FACEAPI_ROLL]		= neutralRoll;
+	m_neutral[FACEAPI_YAW]		= neutralYaw;
+	m_neutral[FACEAPI_PITCH]	= neutralPitch;
+
+	m_presence = new BridgeFilter(new FadeFilter(&hal_fadingDuration_s, new PresenceFilter()));
+
+	Reset();
+}
+
+void OrientationFilter::Reset()
+{
+	m_presence->Reset();
+	m_smoothed.Init(0, 0, 0, 1);
+	m_rotation.Init();
+	m_output.Init(0, 0, 0, 1);
+	m_lastUpdate = 0;
+
+	for(int i = 0; i < 3; i++)
+		m_pose[i] = 0;
+}
+
+void OrientationFilter::Update(FaceAPIData headData)
+{
+	float now = ENGINE_NOW;
+	if(now == m_lastUpdate)
+		return;
+
+	// the neutral filters are shared with the lean, so they may already be
+	// up to date for this frame
+	for(int i = 0; i < 3; i++)
+		m_neutral[i]->Update(headData);
+
+	// the tracker's angles, and so the neutral, are Euler angles
+	Quaternion head, neutral, inverse, relative;
+	AnglesToQuaternion(headData.h_headPos[FACEAPI_ROLL], headData.h_headPos[FACEAPI_YAW], headData.h_headPos[FACEAPI_PITCH], head);
+	AnglesToQuaternion(m_neutral[FACEAPI_ROLL]->GetNeutral(), m_neutral[FACEAPI_YAW]->GetNeutral(), m_neutral[FACEAPI_PITCH]->GetNeutral(), neutral);
+	inverse.Init(-neutral.x, -neutral.y, -neutral.z, neutral.w);
+	QuaternionMult(inverse, head, relative);
+
+	// as the SmoothFilter, but along the shortest arc. The steps are small
+	// enough that a normalised lerp stays on the arc without a slerp's trig
+	float duration = m_smoothing->GetFloat();
+	float damp = (m_lastUpdate > 0 && duration > 0) ? clamp((now - m_lastUpdate) / duration, 0, 1) : 1;
+	Quaternion smoothed;
+	QuaternionBlend(m_smoothed, relative, damp, smoothed);
+	m_smoothed = smoothed;
+	m_lastUpdate = now;
+
+	Vector rotation;
+	UTIL_QuaternionToRotation(m_smoothed, rotation);
+
+	float scale = hal_handyScale_f.GetFloat() * m_scale->GetFloat();
+	rotation.x *= hal_handyScaleRoll_f.GetFloat() * scale;
+	rotation.y *= hal_handyScalePitch_f.GetFloat() * scale;
+	rotation.z *= hal_handyScaleYaw_f.GetFloat() * scale;
+
+	// how far the rotation is towards the limits, with an axis without a
+	// limit left out
+	float limits[3] = { hal_handyMaxRoll_deg.GetFloat(), hal_handyMaxPitch_deg.GetFloat(), hal_handyMaxYaw_deg.GetFloat() };
+	float extent = 0;
+	for(int i = 0; i < 3; i++)
+	{
+		if(limits[i] > 0)
+			extent += (rotation[i] / limits[i]) * (rotation[i] / limits[i]);
+	}
+	extent = sqrt(extent);
+
+	if(extent > 0)
+	{
+		// only the limited axes are eased
+		float ease = EaseOutLimit(extent) / extent;
+		for(int i = 0; i < 3; i++)
+		{
+			if(limits[i] > 0)
+				rotation[i] *= ease;
+		}
+	}
+
+	m_rotation = rotation;
+	UpdatePose(m_presence->Update(headData));
+}
+
+void OrientationFilter::Update()
+{
+	float now = ENGINE_NOW;
+	if(now == m_lastUpdate)
+		return;
+
+	m_lastUpdate = now;
+	UpdatePose(m_presence->Update());
+}
+
+// Fading the rotation vector is the same as a slerp towards no rotation
+void OrientationFilter::UpdatePose(float presence)
+{
+	m_pose[FACEAPI_ROLL]	= -m_rotation.x * presence;
+	m_pose[FACEAPI_PITCH]	= -m_rotation.y * presence;
+	m_pose[FACEAPI_YAW]		= m_rotation.z * presence;
+
+	UTIL_RotationToQuaternion(m_rotation * presence, m_output);
+}
@@ -0,0 +1,74 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_ORIENTATION_FILTER_H
+#define HAL_ORIENTATION_FILTER_H
+
+#include "hal/data_filtering.h"
+#include "mathlib/mathlib.h"
+
+
+// Filters the roll, yaw and pitch together as a single rotation, rather than
+// as three separate angles (see hal_handyOrientation). Smoothing the angles
+// separately bends combined movements, such as looking down while leaning,
+// and falls apart as the pitch gets large.
+//
+// It follows the same steps as the angle chains in HALTechnique::Init: the
+// neutral is taken off as a reference rotation, the rotation is smoothed
+// along the shortest arc, then scaled and limited as a rotation vector (the
+// axis times the angle). The limits form an ellipsoid, so a single axis is
+// limited exactly as the LimitFilter would.
+//
+// The result is kept as a rotation, which is what the view is built from,
+// and as the rotation vector in place of the roll, yaw and pitch for the
+// rest of the game (such as the weapon pull-back). The rotation vector
+// matches the angles for a turn about a single axis. The angle conversions
+// all happen once for each tracker sample, rather than for each frame
+class OrientationFilter
+{
+public:
+	OrientationFilter(MeanOffsetFilter *neutralRoll, MeanOffsetFilter *neutralYaw, MeanOffsetFilter *neutralPitch,
+			TunableVar *smoothing, TunableVar *scale);
+
+	void	Reset();
+	void	Update(FaceAPIData headData);
+	void	Update();	// while there is no tracking
+
+	float	GetRoll() const { return m_pose[FACEAPI_ROLL]; }
+	float	GetYaw() const { return m_pose[FACEAPI_YAW]; }
+	float	GetPitch() const { return m_pose[FACEAPI_PITCH]; }
+	const Quaternion& GetRotation() const { return m_output; }
+
+private:
+	void	UpdatePose(float presence);
+
+	MeanOffsetFilter	*m_neutral[3];	// indexed by FACEAPI_ROLL to FACEAPI_PITCH
+	TunableVar			*m_smoothing;
+	TunableVar			*m_scale;
+
+	// fades the rotation in and out, bridging short drop-outs like the chains
+	Filter				*m_presence;
+
+	Quaternion			m_smoothed;
+	Vector				m_rotation;		// scaled and limited, in degrees
+	float				m_pose[3];
+	Quaternion			m_output;		// the same as m_pose
+	float				m_lastUpdate;
+};
+
+
+// Between a rotation and its rotation vector (in degrees)
+void UTIL_QuaternionToRotation(const Quaternion &q, Vector &rotation);
+void UTIL_RotationToQuaternion(const Vector &rotation, Quaternion &q);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_PLAYER_LEAN_H
+#define HAL_PLAYER_LEAN_H
+
+// The lean is performed in shared code (player_lean_Source.cpp), so that the
+// local player can predict their own lean rather than waiting on the server.
+// Both player classes pull in the same state using the macros below:
+//
+//	CBasePlayer (player.h)			- HAL_LEAN_MEMBERS
+//	C_BasePlayer (c_baseplayer.h)	- HAL_LEAN_MEMBERS
+//	DT_LocalPlayerExclusive			- HAL_LEAN_SENDPROPS (server) / HAL_LEAN_RECVPROPS (client)
+//	C_BasePlayer prediction desc	- HAL_LEAN_PREDFIELDS
+//
+// Both sides lean from PostThink (LeanThink), which the server's
+// CPlayerMove::RunCommand and the client's CPrediction::RunCommand call once
+// per command, straight after the movement. Any server correction then
+// arrives through the send table and the pending commands are replayed on
+// top of it, just like the rest of the movement state.
+//
+// In multiplayer the server holds back the lean of each player's last command
+// in the tick, so that the traces of all the players can be resolved together
+// on the thread pool (lean_stage_Source.cpp). Any earlier command in the same
+// tick is still leaned straight away, so the next command starts from the
+// leaned origin just as it does in the client's prediction.
+
+class CBasePlayer;
+
+// A single lean movement, split out so the collision part can be resolved
+// away from the player (see lean_stage_Source.cpp)
+class LeanRequest
+{
+public:
+	LeanRequest()
+		: player(NULL), origin(0, 0, 0), right(0, 0, 0), movementAmount(0), fraction(1), offset(0, 0, 0) {};
+
+	// filled in by PrepareLean
+	CBasePlayer	*player;
+	Vector		origin;
+	Vector		right;
+	float		movementAmount;
+
+	// filled in by UTIL_ResolveLean
+	float		fraction;
+	Vector		offset;
+};
+
+void UTIL_ResolveLean(LeanRequest &request);
+
+#ifndef CLIENT_DLL
+bool UTIL_IsLeanStageActive();
+#endif
+
+
+#define HAL_LEAN_MEMBERS \
+	public: \
+		void	LeanThink(); \
+		void	PerformLean(float amount); \
+		bool	PrepareLean(float amount, LeanRequest &request); \
+		void	ApplyLean(const LeanRequest &request); \
+		float	GetLeanAmount() const { return -m_leanAmount_p; } \
+	private: \
+		CNetworkVar(float, m_movementReserve); \
+		CNetworkVar(float, m_leanAmount_p);
+
+#define HAL_LEAN_SENDPROPS \
+	SendPropFloat	(SENDINFO(m_leanAmount_p),		0, SPROP_NOSCALE|SPROP_CHANGES_OFTEN ), \
+	SendPropFloat	(SENDINFO(m_movementReserve),	0, SPROP_NOSCALE|SPROP_CHANGES_OFTEN ),
+
+#define HAL_LEAN_RECVPROPS \
+	RecvPropFloat	(RECVINFO(m_leanAmount_p)), \
+	RecvPropFloat	(RECVINFO(m_movementReserve)),
+
+#define HAL_LEAN_PREDFIELDS \
+	DEFINE_PRED_FIELD( m_leanAmount_p, FIELD_FLOAT, FTYPEDESC_INSENDTABLE ), \
+	DEFINE_PRED_FIELD( m_movementReserve, FIELD_FLOAT, FTYPEDESC_INSENDTABLE ),
+
+#endif
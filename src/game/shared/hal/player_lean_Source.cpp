@@ -1,4 +1,8 @@
 #include "cbase.h"
+
+#ifdef CLIENT_DLL
+#include "c_baseplayer.h"
+#else
 #include "const.h"
 #include "baseplayer_shared.h"
 #include "trains.h"
@@ -61,104 +65,166 @@
 #include "gameinterface.h"
 #include "hl2orange.spa.h"
 // taken from player.cpp
+#endif
 
 #include "hal/util.h"
+#include "hal/lean_solver.h"
 
-#define LEANSIZE_IN_VIRTUAL_METERS		1
-#define PLAYER_SIZE						32
-#define PLAYER_HEIGHT					72
 #define VF "%6.3f"
 
 
+// The engine's side of the lean: hull traces against the world, ignoring the
+// player doing the leaning
+class EngineLeanWorld : public ILeanWorld
+{
+public:
+	EngineLeanWorld(CBasePlayer *player) : m_player(player) {}
+
+	float TraceHull(const Vector &start, const Vector &end, const Vector &hullMin, const Vector &hullMax)
+	{
+		trace_t tr;
+		UTIL_TraceHull(
+				start,
+				end,
+				hullMin, 
+				hullMax,
+				MASK_SOLID, 
+				m_player, 
+				COLLISION_GROUP_PLAYER_MOVEMENT, 
+				&tr);
+		return tr.fraction;
+	}
+
+private:
+	CBasePlayer *m_player;
+};
+
+
+// Shared between the server and the client. The client runs this for the local
+// player as part of its movement prediction, so the lean state (the reserve in
+// particular) must only ever be derived from the commands and the world.
+
+// Called from PostThink, so only while a command is being run. The lean is
+// made per command on both sides, as that is how the client predicts it. The
+// server may hold the last one back until the end of the tick (see RunLean).
+
+void CBasePlayer::LeanThink()
+{
+	if(!m_pCurrentCommand)
+		return;
+
+#ifdef CLIENT_DLL
+	PerformLean(m_pCurrentCommand->lean);
+#else
+	RunLean(m_pCurrentCommand->lean);
+#endif
+}
+
 void CBasePlayer::PerformLean( float amount )
 {
-	Vector hullMin, hullMax;
-	Vector sidestep, rise;
-	Vector pForward, pRight, pUp, pOrigin;
+	LeanRequest request;
+
+	if(!PrepareLean(amount, request))
+		return;
+
+	UTIL_ResolveLean(request);
+	ApplyLean(request);
+}
+
+// Updates the lean amount and the movement reserve. Returns false if there
+// is no movement to be made, in which case no request is produced
+
+bool CBasePlayer::PrepareLean( float amount, LeanRequest &request )
+{
+	Vector pForward, pRight, pUp;
 	QAngle pAngles;
 	
 	// GetAbsAngles()						- changes based on where the user is looking
 	// GetAbsAngles() & GetLocalAngles()	- return the same thing
-	pOrigin = GetAbsOrigin();
 	pAngles = GetAbsAngles();
 	AngleVectors(pAngles, &pForward, &pRight, &pUp);
 
-	amount *= -1; // make our right and Source's right consistent
+	LeanState state;
+	state.leanAmount	= m_leanAmount_p;
+	state.reserve		= m_movementReserve;
+
+	float movementAmount = LeanSolver::Prepare(state, amount);
+
+	m_leanAmount_p		= state.leanAmount;
+	m_movementReserve	= state.reserve;
 
-	float diff = amount - m_leanAmount_p;
-	m_leanAmount_p = amount;
+	if(movementAmount == 0.0f) 
+		return false;
 
-	float movementAmount = METERS_TO_SOURCE(diff) * LEANSIZE_IN_VIRTUAL_METERS;
+	request.player			= this;
+	request.origin			= GetAbsOrigin();
+	request.right			= pRight;
+	request.movementAmount	= movementAmount;
+	return true;
+}
 
-	if(movementAmount == 0.0f && amount == 0.0f)
-		m_movementReserve = 0.0f;
+// Only reads the world (and the request), so it is safe to run the requests
+// of several players at the same time
 
-	// example: move reserve => move reserve
-	//			  30     -40       0     -10
-	//			  30     -20      10       0
-	//            30      10       0      40
-	//			 -30      40       0      10
-	//			 -30      20     -10       0
-	//           -30     -10       0     -40
-	if(m_movementReserve != 0.0f)
+void UTIL_ResolveLean( LeanRequest &request )
+{
+	EngineLeanWorld world(request.player);
+	LeanSolver::Resolve(&world, request.origin, request.right, request.movementAmount, request.fraction, request.offset);
+}
+
+void CBasePlayer::ApplyLean( const LeanRequest &request )
+{
+	bool alive = (m_lifeState != LIFE_DEAD);
+
+	LeanState state;
+	state.reserve		= m_movementReserve;
+
+	LeanSolver::Apply(state, request.movementAmount, request.fraction);
+
+	m_movementReserve	= state.reserve;
+
+	if(alive)
+		SetAbsOrigin(request.origin + request.offset);
+}
+
+
+#ifndef CLIENT_DLL
+
+// When the lean stage is active the lean is queued until all of the players
+// have run their commands for the tick, otherwise it is performed straight away
+
+void CBasePlayer::RunLean(float amount)
+{
+	if(UTIL_IsLeanStageActive())
 	{
-		if(movementAmount/m_movementReserve < 0)
-		{
-			// might need to absorb some movement if obsticles are involved
-			float newReserve = m_movementReserve + movementAmount;
-			movementAmount = 0.0f;
-
-			if(newReserve/m_movementReserve < 0.0f)
-			{
-				// exceeded how much we had in reserve
-				movementAmount = newReserve;
-				newReserve = 0.0f;
-			}
-			m_movementReserve = newReserve;
-		}
+		m_queuedLean = amount;
+		m_leanQueued = true;
+		return;
 	}
 
-	if(movementAmount == 0.0f) return;
-
-	hullMin = Vector(-PLAYER_SIZE/2, -PLAYER_SIZE/2, 0);
-	hullMax = Vector( PLAYER_SIZE/2,  PLAYER_SIZE/2, PLAYER_HEIGHT);
-
-	// we try to rise up as much as we sidestep in case of a slope
-	// we don't use pUp, as this is based on the looking angle
-	rise		= Vector(0,0,1)	* fabs(movementAmount); 
-	sidestep	= pRight		* movementAmount;
-
-	trace_t tr;
-	UTIL_TraceHull(
-			pOrigin,
-			pOrigin + rise + sidestep,
-			hullMin, 
-			hullMax,
-			MASK_SOLID, 
-			this, 
-			COLLISION_GROUP_PLAYER_MOVEMENT, 
-			&tr);
-
-	sidestep	*= tr.fraction; // amount of movement we can actually make
-	rise		*= tr.fraction;
-
-	m_movementReserve += (1.0f - tr.fraction) * movementAmount; // note how much we did not move
-
-	UTIL_TraceHull(
-			pOrigin + sidestep + rise,
-			pOrigin + sidestep - rise, // allow for stepping down
-			hullMin, 
-			hullMax,
-			MASK_SOLID, 
-			this, 
-			COLLISION_GROUP_PLAYER_MOVEMENT, 
-			&tr);
-
-	rise *= 1.0f - 2 * tr.fraction;
-	
-	pOrigin += sidestep;
-	pOrigin += rise;
+	PerformLean(amount);
+}
+
+bool CBasePlayer::TakeQueuedLean(float &amount)
+{
+	if(!m_leanQueued)
+		return false;
+
+	amount = m_queuedLean;
+	m_leanQueued = false;
+	return true;
+}
+
+// Called before each command's movement. If an earlier command in the same
+// tick left its lean queued, it is made now so that the movement starts from
+// the leaned origin, as it does in the client's prediction. Only the last
+// lean of the tick ever reaches the lean stage
+
+void CBasePlayer::FlushQueuedLean()
+{
+	float amount;
+	if(TakeQueuedLean(amount))
+		PerformLean(amount);
+}
 
-	if(!IsDead())
-		SetAbsOrigin(pOrigin);
-}
\ No newline at end of file
+#endif
@@ -0,0 +1,134 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+
+#include "hal/pose_interpolation.h"
+
+
+void PoseInterpolator::Reset()
+{
+	m_newest = -1;
+	m_count = 0;
+}
+
+void PoseInterpolator::Add(float time, const float *values, const Quaternion &rotation)
+{
+	if(m_count > 0 && time <= Get(0).time)
+	{
+		// the engine time can restart (e.g. on a level change)
+		if(time < Get(0).time - 1)
+		{
+			Reset();
+		}
+		// otherwise the capture time fell behind a pose added while fading,
+		// so it takes that pose's place
+		else
+		{
+			TimedPose &pose = m_poses[m_newest];
+			for(int i = 0; i < POSE_CHANNELS; i++)
+				pose.values[i] = values[i];
+			pose.rotation = rotation;
+			return;
+		}
+	}
+
+	m_newest = (m_newest + 1) % POSE_HISTORY;
+	m_count = min(m_count + 1, POSE_HISTORY);
+
+	TimedPose &pose = m_poses[m_newest];
+	pose.time = time;
+	for(int i = 0; i < POSE_CHANNELS; i++)
+		pose.values[i] = values[i];
+	pose.rotation = rotation;
+}
+
+float PoseInterpolator::GetInterval() const
+{
+	if(m_count < 2)
+		return 0;
+
+	return (Get(0).time - Get(m_count - 1).time) / (m_count - 1);
+}
+
+const TimedPose& PoseInterpolator::Get(int age) const
+{
+	return m_poses[(m_newest - age + POSE_HISTORY) % POSE_HISTORY];
+}
+
+// Catmull-Rom style tangent, allowing for uneven gaps between the poses
+float PoseInterpolator::Tangent(int age, int channel) const
+{
+	int newer = max(age - 1, 0);
+	int older = min(age + 1, m_count - 1);
+
+	float dt = Get(newer).time - Get(older).time;
+	if(dt <= 0)
+		return 0;
+
+	return (Get(newer).values[channel] - Get(older).values[channel]) / dt;
+}
+
+void PoseInterpolator::Evaluate(float time, float maxExtrapolate, float *values, Quaternion &rotation) const
+{
+	if(m_count == 0)
+	{
+		for(int i = 0; i < POSE_CHANNELS; i++)
+			values[i] = 0;
+		rotation.Init(0, 0, 0, 1);
+		return;
+	}
+
+	const TimedPose &newest = Get(0);
+
+	if(m_count == 1 || time >= newest.time)
+	{
+		float ahead = clamp(time - newest.time, 0, maxExtrapolate);
+		for(int i = 0; i < POSE_CHANNELS; i++)
+			values[i] = newest.values[i] + ((m_count > 1) ? Tangent(0, i) * ahead : 0);
+
+		float dt = (m_count > 1) ? newest.time - Get(1).time : 0;
+		if(dt > 0)
+			QuaternionSlerp(Get(1).rotation, newest.rotation, 1 + ahead / dt, rotation);
+		else
+			rotation = newest.rotation;
+		return;
+	}
+
+	// find the pair of poses either side of the time
+	int age = 1;
+	while(age < m_count - 1 && Get(age).time > time)
+		age++;
+
+	const TimedPose &p0 = Get(age);
+	const TimedPose &p1 = Get(age - 1);
+
+	float dt = p1.time - p0.time;
+	float s = clamp((time - p0.time) / dt, 0, 1);
+	float s2 = s * s;
+	float s3 = s2 * s;
+
+	float h00 =  2*s3 - 3*s2 + 1;
+	float h10 =    s3 - 2*s2 + s;
+	float h01 = -2*s3 + 3*s2;
+	float h11 =    s3 -   s2;
+
+	for(int i = 0; i < POSE_CHANNELS; i++)
+	{
+		values[i] = 
+			h00 * p0.values[i] + h10 * dt * Tangent(age, i) +
+			h01 * p1.values[i] + h11 * dt * Tangent(age - 1, i);
+	}
+
+	QuaternionSlerp(p0.rotation, p1.rotation, s, rotation);
+}
@@ -0,0 +1,62 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_POSE_INTERPOLATION_H
+#define HAL_POSE_INTERPOLATION_H
+
+#include "mathlib/mathlib.h"
+
+#define POSE_CHANNELS	6
+#define POSE_HISTORY	4
+
+
+class TimedPose
+{
+public:
+	TimedPose() : time(0) { for(int i = 0; i < POSE_CHANNELS; i++) values[i] = 0; rotation.Init(0, 0, 0, 1); }
+
+	float		time;
+	float		values[POSE_CHANNELS];
+	Quaternion	rotation;	// from the OrientationFilter, when it is in use
+};
+
+
+// Keeps the last few filtered poses, stamped with the time they were captured,
+// and evaluates the pose in between them. This lets each rendered frame use the
+// pose for its own time, rather than stepping along at the camera's rate.
+class PoseInterpolator
+{
+public:
+	PoseInterpolator() { Reset(); }
+
+	void	Reset();
+	void	Add(float time, const float *values, const Quaternion &rotation);
+	int		Count() const { return m_count; }
+	float	GetInterval() const;	// the average gap between the poses, 0 if unknown
+
+	// Cubic Hermite between the surrounding poses. Past the newest pose the
+	// last velocity is carried on for up to maxExtrapolate seconds. The
+	// rotation is slerped between the same pair of poses (or beyond the
+	// newest), so it stays on the arc between them
+	void	Evaluate(float time, float maxExtrapolate, float *values, Quaternion &rotation) const;
+
+private:
+	const TimedPose&	Get(int age) const;	// 0 is the newest
+	float				Tangent(int age, int channel) const;
+
+	TimedPose	m_poses[POSE_HISTORY];
+	int			m_newest;
+	int			m_count;
+};
+
+#endif
@@ -0,0 +1,222 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+#include "filesystem.h"
+#include "utlbuffer.h"
+#include "utlvector.h"
+#include "tier0/threadtools.h"
+
+#include "hal/head_tracker.h"
+#include "hal/engine_dependencies.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+ConVar hal_replayFile("hal_replayFile", "hal_scope.csv", FCVAR_ARCHIVE, "The recording (from hal_scopeDump) played back by the replay tracker");
+
+
+// Plays back the raw head data recorded by hal_scopeDump, looping at the end.
+// This allows the filtering to be tested, and tuned, without a camera
+class ReplayTracker: public HeadTrackerBackend
+{
+public:
+	ReplayTracker() : m_thread(NULL), m_duration(0) {}
+
+	const char*		GetName() { return "replay"; }
+	int				GetCapabilities() { return TRACKER_ROTATION | TRACKER_POSITION | TRACKER_CONFIDENCE | TRACKER_TIMESTAMPS; }
+	float			GetNativeRate() { return (m_duration > 0) ? m_samples.Count() / m_duration : 0; }
+
+	void			Play();
+
+protected:
+	bool			InitTracking();
+	void			ShutdownTracking();
+
+private:
+	bool			Load(const char *fileName);
+
+	class PlaybackThread: public CThread
+	{
+	public:
+		PlaybackThread(ReplayTracker *tracker) : m_tracker(tracker) {}
+		int Run() { m_tracker->Play(); return 0; }
+
+	private:
+		ReplayTracker *m_tracker;
+	};
+
+	CUtlVector<FaceAPIData>	m_samples;	// h_time is from the start of the recording
+	float					m_duration;
+
+	PlaybackThread			*m_thread;
+};
+
+REGISTER_HEAD_TRACKER(ReplayTracker, "replay", "Plays back a recording made with hal_scopeDump");
+
+
+#define REPLAY_MAX_COLUMNS	32
+
+// Splits a line of the CSV in place, returning the number of fields
+static int SplitLine(char *line, char **fields)
+{
+	int count = 0;
+	for(char *c = line; count < REPLAY_MAX_COLUMNS; c++)
+	{
+		fields[count++] = c;
+		c = strchr(c, ',');
+		if(!c)
+			break;
+		*c = '\0';
+	}
+	return count;
+}
+
+// Finds the column by name, or returns -1
+static int FindColumn(char **columns, int count, const char *name)
+{
+	for(int i = 0; i < count; i++)
+	{
+		if(!Q_strnicmp(columns[i], name, Q_strlen(name)) && columns[i][Q_strlen(name)] <= ' ')
+			return i;
+	}
+	return -1;
+}
+
+bool ReplayTracker::Load(const char *fileName)
+{
+	CUtlBuffer file(0, 0, CUtlBuffer::TEXT_BUFFER);
+	if(!filesystem->ReadFile(fileName, "MOD", file))
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to read %s", fileName);
+		return false;
+	}
+
+	char line[1024];
+	char *fields[REPLAY_MAX_COLUMNS];
+	file.GetLine(line, sizeof(line));
+	int count = SplitLine(line, fields);
+
+	// the raw channels, indexed by FACEAPI_*
+	int channels[6];
+	channels[FACEAPI_ROLL]	= FindColumn(fields, count, "raw_roll");
+	channels[FACEAPI_YAW]	= FindColumn(fields, count, "raw_yaw");
+	channels[FACEAPI_PITCH]	= FindColumn(fields, count, "raw_pitch");
+	channels[FACEAPI_VERT]	= FindColumn(fields, count, "raw_vert");
+	channels[FACEAPI_SIDEW]	= FindColumn(fields, count, "raw_sidew");
+	channels[FACEAPI_DEPTH]	= FindColumn(fields, count, "raw_depth");
+	int timeColumn			= FindColumn(fields, count, "time");
+	int confColumn			= FindColumn(fields, count, "confidence");
+
+	if(timeColumn < 0)
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "%s has no time column", fileName);
+		return false;
+	}
+
+	while(file.IsValid() && file.GetBytesRemaining() > 0)
+	{
+		file.GetLine(line, sizeof(line));
+		count = SplitLine(line, fields);
+		if(count <= timeColumn)
+			continue;
+
+		FaceAPIData sample;
+		for(int i = 0; i < 6; i++)
+		{
+			if(channels[i] >= 0 && channels[i] < count)
+				sample.h_headPos[i] = atof(fields[channels[i]]);
+		}
+		sample.h_confidence = (confColumn >= 0 && confColumn < count) ? atof(fields[confColumn]) : 1.0f;
+		sample.h_time = atof(fields[timeColumn]);
+
+		// keep the times relative to the start, and in order
+		if(m_samples.Count() > 0)
+		{
+			sample.h_time -= m_samples[0].h_time;
+			if(sample.h_time < m_samples.Tail().h_time)
+				continue;
+		}
+		m_samples.AddToTail(sample);
+	}
+
+	if(m_samples.Count() < 2)
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "%s has no samples", fileName);
+		return false;
+	}
+
+	// the loop is one (average) sample longer, so the last and first samples
+	// aren't published together
+	m_samples[0].h_time = 0;
+	m_duration = m_samples.Tail().h_time * m_samples.Count() / (m_samples.Count() - 1);
+	return true;
+}
+
+bool ReplayTracker::InitTracking()
+{
+	m_samples.RemoveAll();
+	if(!Load(hal_replayFile.GetString()))
+		return false;
+
+	m_thread = new PlaybackThread(this);
+	if(!m_thread->Start())
+	{
+		delete m_thread;
+		m_thread = NULL;
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to start the playback thread");
+		return false;
+	}
+
+	engine_printf("Replaying %d samples (%.1f seconds) from %s\n", m_samples.Count(), m_duration, hal_replayFile.GetString());
+	return true;
+}
+
+void ReplayTracker::ShutdownTracking()
+{
+	if(!m_thread)
+		return;
+
+	m_thread->Join();
+	delete m_thread;
+	m_thread = NULL;
+}
+
+// Publishes each sample when its time comes around, with the recording
+// repeating back to back
+void ReplayTracker::Play()
+{
+	float start = ENGINE_NOW;
+	int next = 0;
+
+	while(!IsStopping())
+	{
+		float offset = ENGINE_NOW - start;
+		if(offset >= m_samples[next].h_time)
+		{
+			FaceAPIData &data = GetWriteData();
+			data = m_samples[next];
+			data.h_time += start;
+			PublishData();
+
+			if(++next == m_samples.Count())
+			{
+				next = 0;
+				start += m_duration;
+			}
+			continue;
+		}
+
+		WaitForStop(max((int)((m_samples[next].h_time - offset) * 1000), 1));
+	}
+}
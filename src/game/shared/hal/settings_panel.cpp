@@ -2,6 +2,7 @@
 
 #include <vgui/ILocalize.h>
 #include "filesystem.h"
+#include "icvar.h"
 
 #include "hal/settings_panel.h"
 #include "hal/hal.h"
@@ -30,6 +31,62 @@ CON_COMMAND(ResetHeadPosition, NULL)
 
 
 
+// --------------------------------------------------------
+// CONVAR CONTROL
+// --------------------------------------------------------
+CUtlVector<HTConVarControl*> HTConVarControl::s_controls;
+CUtlVector<HTConVarControl*> HTConVarControl::s_pending;
+
+HTConVarControl::HTConVarControl(TunableVar *var)
+{
+	m_conVar = var;
+
+	if(s_controls.Count() == 0)
+		g_pCVar->InstallGlobalChangeCallback(&HTConVarControl::OnConVarChanged);
+	s_controls.AddToTail(this);
+
+	// picks up the current value on the first think
+	m_pending = true;
+	s_pending.AddToTail(this);
+}
+
+HTConVarControl::~HTConVarControl()
+{
+	s_controls.FindAndRemove(this);
+	s_pending.FindAndRemove(this);
+
+	if(s_controls.Count() == 0)
+		g_pCVar->RemoveGlobalChangeCallback(&HTConVarControl::OnConVarChanged);
+}
+
+void HTConVarControl::OnConVarChanged(IConVar *var, const char *pOldValue, float flOldValue)
+{
+	for(int i = 0; i < s_controls.Count(); i++)
+	{
+		HTConVarControl *control = s_controls[i];
+		if(static_cast<IConVar*>(control->m_conVar) == var && !control->m_pending)
+		{
+			control->m_pending = true;
+			s_pending.AddToTail(control);
+		}
+	}
+}
+
+void HTConVarControl::SyncChanged()
+{
+	for(int i = 0; i < s_pending.Count(); i++)
+	{
+		s_pending[i]->m_pending = false;
+		if(s_pending[i]->m_conVar)
+			s_pending[i]->SyncFromConVar();
+	}
+	s_pending.RemoveAll();
+}
+
+
+
+
+
 #define SLIDER_SCALE_FLOAT2INT 100.0f 
 
 void HTSlider::SetValue(int value, bool bTriggerChangeMessage)
@@ -52,10 +109,9 @@ void HTSlider::GetRange(float &min, float &max)
 	max = iMax / SLIDER_SCALE_FLOAT2INT;
 }
 
-void HTSlider::OnThink()
+void HTSlider::SyncFromConVar()
 {
-	Slider::OnThink();
-	if(m_conVar && m_conVar->GetFloat() != GetValue()/SLIDER_SCALE_FLOAT2INT)
+	if(m_conVar->GetFloat() != GetValue()/SLIDER_SCALE_FLOAT2INT)
 		vgui::Slider::SetValue(int (m_conVar->GetFloat() * SLIDER_SCALE_FLOAT2INT));
 }
 
@@ -63,9 +119,8 @@ void HTSlider::OnThink()
 
 
 
-HTTextEntry::HTTextEntry(Panel *parent, const char *panelName, ConVar *var) : TextEntry(parent, panelName)
+HTTextEntry::HTTextEntry(Panel *parent, const char *panelName, ConVar *var) : TextEntry(parent, panelName), HTConVarControl(var)
 { 
-	m_conVar = var;
 	SetAllowNumericInputOnly(true);
 	m_value = -1;
 }
@@ -83,12 +138,12 @@ void HTTextEntry::OnKeyTyped(wchar_t unichar)
 }
 
 
-void HTTextEntry::OnThink()
+// Leaves the text alone when the change came from typing into it
+void HTTextEntry::SyncFromConVar()
 {
 #define TEXT_ENTRY_BUFLEN 32
 
-	TextEntry::OnThink();
-	if(m_conVar && m_conVar->GetFloat() != m_value)
+	if(m_conVar->GetFloat() != m_value)
 	{
 		char text[TEXT_ENTRY_BUFLEN];
 
@@ -104,11 +159,11 @@ void HTTextEntry::OnThink()
 // --------------------------------------------------------
 // CONVAR RADIO BUTTON
 // --------------------------------------------------------
-HTRadioButton::HTRadioButton(Panel *parent, const char *panelName, const char *text, ConVar *var, int option) : RadioButton(parent, panelName, text)
+HTRadioButton::HTRadioButton(Panel *parent, const char *panelName, const char *text, ConVar *var, int option) 
+		: RadioButton(parent, panelName, text), HTConVarControl(var)
 {
-	m_conVar = var;
 	m_option = option;
-	OnThink();
+	SyncFromConVar();
 }
 
 void HTRadioButton::OnMousePressed(vgui::MouseCode code)
@@ -117,20 +172,18 @@ void HTRadioButton::OnMousePressed(vgui::MouseCode code)
 	m_conVar->SetValue(m_option);
 }
 
-void HTRadioButton::OnThink()
+void HTRadioButton::SyncFromConVar()
 {
-	RadioButton::OnThink();
-	if(m_conVar)
-		SetSelected(m_conVar->GetInt() == m_option);
+	SetSelected(m_conVar->GetInt() == m_option);
 }
 
 
 // --------------------------------------------------------
 // CONVAR CHECK BUTTON
 // --------------------------------------------------------
-HTCheckButton::HTCheckButton(Panel *parent, const char *panelName, const char *text, ConVar *var) : CheckButton(parent, panelName, text)
+HTCheckButton::HTCheckButton(Panel *parent, const char *panelName, const char *text, ConVar *var) 
+		: CheckButton(parent, panelName, text), HTConVarControl(var)
 {
-	m_conVar = var;
 	SetSelected(m_conVar->GetBool());
 }
 
@@ -140,9 +193,8 @@ void HTCheckButton::OnMousePressed(vgui::MouseCode code)
 	m_conVar->SetValue((int)IsSelected());
 }
 
-void HTCheckButton::OnThink()
+void HTCheckButton::SyncFromConVar()
 {
-	CheckButton::OnThink();
 	if(m_conVar->GetBool() != IsSelected())
 		SetSelected(m_conVar->GetBool());
 }
@@ -151,43 +203,37 @@ void HTCheckButton::OnThink()
 // CONVAR COMBO BOX
 // --------------------------------------------------------
 HTComboBox::HTComboBox(Panel *parent, const char *panelName, int numOfValues, std::map<int,char*> & values, ConVar *var)
-		: ComboBox(parent, panelName, numOfValues, false)
+		: ComboBox(parent, panelName, numOfValues, false), HTConVarControl(var)
 {
 	std::map<int,char*>::iterator it;
 
 	// show content:
 	for(it = values.begin(); it != values.end(); it++)
 	{
-		int index = AddItem((*it).second, NULL);
-		m_valueToIndex[(*it).first] = index;
-		m_indexToValue[index]		= (*it).first;
+		m_itemIDs.AddToTail(AddItem((*it).second, NULL));
+		m_values.AddToTail((*it).first);
 	}
 
-	firstThink = true;
 	firstCall = true;
-	m_conVar = var;
 }
 
 void HTComboBox::OnMenuItemSelected()
 {
 	ComboBox::OnMenuItemSelected();
 
-	if(m_conVar && !firstCall)
-		m_conVar->SetValue(m_indexToValue[GetActiveItem()]);
+	int item = m_itemIDs.Find(GetActiveItem());
+	if(m_conVar && !firstCall && item != m_itemIDs.InvalidIndex())
+		m_conVar->SetValue(m_values[item]);
 
 	// hacky, but this always seems to be called when loading
 	firstCall = false;
 }
 
-void HTComboBox::OnThink()
+void HTComboBox::SyncFromConVar()
 {
-	ComboBox::OnThink();
-
-	if(m_conVar && (firstThink || m_conVar->GetInt() != m_indexToValue[GetActiveItem()]))
-	{
-		ActivateItem(m_valueToIndex[m_conVar->GetInt()]);
-		firstThink = false;
-	}
+	int item = m_values.Find(m_conVar->GetInt());
+	if(item != m_values.InvalidIndex() && m_itemIDs[item] != GetActiveItem())
+		ActivateItem(m_itemIDs[item]);
 }
 
 
@@ -318,6 +364,13 @@ void CHTSettingsPanel::OnCommand(const char* command)
 	}
 }
 
+// Only the controls whose ConVars have changed get updated
+void CHTSettingsPanel::OnThink()
+{
+	BaseClass::OnThink();
+	HTConVarControl::SyncChanged();
+}
+
 // positioned under the lean settings, on the left
 void CHTSettingsPanel::SetVisible(bool state)
 {
@@ -6,6 +6,7 @@
 #endif
 
 #include <map>
+#include "utlvector.h"
 
 #include <vgui_controls/panel.h>
 #include <vgui_controls/label.h>
@@ -147,67 +148,86 @@ void AlignPanel(vgui::Panel *pChild, vgui::Panel *pParent, int alignment);
 
 
 
-class HTSlider : public vgui::Slider
+// Keeps a control in step with its ConVar. Rather than every control checking
+// its ConVar each think, the changes are collected as they happen (through
+// the global ConVar change callback) and only the affected controls are
+// updated, on the next think of the panel holding them.
+class HTConVarControl
 {
 public:
-	HTSlider(Panel *parent, const char *panelName, TunableVar *var) : Slider(parent, panelName) { m_conVar = var; }
+	HTConVarControl(TunableVar *var);
+	virtual ~HTConVarControl();
+
+	virtual void	SyncFromConVar() = 0;
+	static void		SyncChanged();
+
+protected:
+	TunableVar		*m_conVar;
+
+private:
+	static void		OnConVarChanged(IConVar *var, const char *pOldValue, float flOldValue);
+
+	bool			m_pending;
+
+	static CUtlVector<HTConVarControl*>	s_controls;
+	static CUtlVector<HTConVarControl*>	s_pending;
+};
+
+
+class HTSlider : public vgui::Slider, public HTConVarControl
+{
+public:
+	HTSlider(Panel *parent, const char *panelName, TunableVar *var) : Slider(parent, panelName), HTConVarControl(var) {}
 
 	void	SetValue(int value, bool bTriggerChangeMessage = true);
     void	SetRange(float min, float max);	 // set to max and min range of rows to display
 	void	GetRange(float &min, float &max);
 	
-	void OnThink();
-private:
-	TunableVar *m_conVar;
+	void SyncFromConVar();
 };
 
-class HTTextEntry : public vgui::TextEntry
+class HTTextEntry : public vgui::TextEntry, public HTConVarControl
 {
 public:
 	HTTextEntry(Panel *parent, const char *panelName, TunableVar *var);
 	virtual void OnKeyTyped(wchar_t unichar);
-	void OnThink();
+	void SyncFromConVar();
 private:
-	TunableVar *m_conVar;
 	float	m_value;
 };
 
-class HTRadioButton : public vgui::RadioButton
+class HTRadioButton : public vgui::RadioButton, public HTConVarControl
 {
 	//DECLARE_CLASS_SIMPLE( HTRadioButton, vgui::RadioButton );
 public:
 	HTRadioButton(Panel *parent, const char *panelName, const char *text, TunableVar *var, int option);
-	void OnThink();
+	void SyncFromConVar();
 	void OnMousePressed(vgui::MouseCode code);
 private:
-	TunableVar *m_conVar;
 	int m_option;
 };
 
 
-class HTCheckButton : public vgui::CheckButton
+class HTCheckButton : public vgui::CheckButton, public HTConVarControl
 {
 public:
 	HTCheckButton(Panel *parent, const char *panelName, const char *text, TunableVar *var);
 	void OnMousePressed(vgui::MouseCode code);
-	void OnThink();
-private:
-	TunableVar *m_conVar;
+	void SyncFromConVar();
 };
 
 
-class HTComboBox : public vgui::ComboBox
+class HTComboBox : public vgui::ComboBox, public HTConVarControl
 {
 public:
 	HTComboBox(Panel *parent, const char *panelName, int numOfValues, std::map<int,char*> & values, TunableVar *var);
-	void OnThink();
+	void SyncFromConVar();
 protected:
 	void OnMenuItemSelected();
 private:
-	std::map<int,int> m_indexToValue;
-	std::map<int,int> m_valueToIndex;
-	TunableVar *m_conVar;
-	bool firstThink;
+	// the items and the ConVar values they stand for, side by side
+	CUtlVector<int> m_itemIDs;
+	CUtlVector<int> m_values;
 	bool firstCall;
 };
 
@@ -224,7 +244,7 @@ class CHTSettingsPanel : public vgui::Frame
 
 	void OnCommand(const char* command);
 	void SetVisible(bool state);
-	//void OnThink();
+	void OnThink();
 
 private:
 	vgui::Button *m_close;
@@ -0,0 +1,200 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+#include "tier0/threadtools.h"
+
+#include "hal/head_tracker.h"
+#include "hal/shm_tracker.h"
+#include "hal/engine_dependencies.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+// How many times the reader checks for a new record before it sleeps
+#define SHM_SPIN_COUNT		2000
+
+// The longest the reader sleeps for, in case a new writer has replaced the
+// ring without signalling
+#define SHM_MAX_WAIT_MS		50
+
+
+// Reads the poses written to shared memory by another process (see
+// shm_tracker.h). This keeps a heavy tracker out of the game's process,
+// without the latency of going through the network stack
+class SharedMemoryTracker: public HeadTrackerBackend
+{
+public:
+	SharedMemoryTracker() : m_mapping(NULL), m_event(NULL), m_ring(NULL), m_thread(NULL) {}
+
+	const char*		GetName() { return "shm"; }
+	int				GetCapabilities() { return TRACKER_ROTATION | TRACKER_POSITION | TRACKER_CONFIDENCE | TRACKER_TIMESTAMPS | TRACKER_FRAMES; }
+	float			GetNativeRate() { return (m_ring && m_ring->magic == HEADPOSE_SHM_MAGIC) ? m_ring->nativeRate : 0; }
+
+	void			Read();
+
+protected:
+	bool			InitTracking();
+	void			ShutdownTracking();
+
+private:
+	bool			ReadRecord(LONG sequence, HeadPoseRecord &record);
+	void			Publish(const HeadPoseRecord &record);
+	void			WaitForWriter(LONG next);
+	void			WaitForWriterOrStop(DWORD timeoutMs);
+
+	class ReadThread: public CThread
+	{
+	public:
+		ReadThread(SharedMemoryTracker *tracker) : m_tracker(tracker) {}
+		int Run() { m_tracker->Read(); return 0; }
+
+	private:
+		SharedMemoryTracker *m_tracker;
+	};
+
+	HANDLE			m_mapping;
+	HANDLE			m_event;
+	HeadPoseRing	*m_ring;
+
+	ReadThread		*m_thread;
+};
+
+REGISTER_HEAD_TRACKER(SharedMemoryTracker, "shm", "Reads poses from another process through shared memory");
+
+
+// The ring is created by whichever side gets there first, so the game and
+// the tracker can be started in either order
+bool SharedMemoryTracker::InitTracking()
+{
+	m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(HeadPoseRing), HEADPOSE_SHM_NAME);
+	m_event = CreateEventA(NULL, FALSE, FALSE, HEADPOSE_SHM_EVENT);
+	if(m_mapping)
+		m_ring = (HeadPoseRing*)MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(HeadPoseRing));
+
+	if(!m_ring || !m_event)
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to open %s (error %d)", HEADPOSE_SHM_NAME, GetLastError());
+		ShutdownTracking();
+		return false;
+	}
+
+	m_thread = new ReadThread(this);
+	if(!m_thread->Start())
+	{
+		delete m_thread;
+		m_thread = NULL;
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to start the read thread");
+		ShutdownTracking();
+		return false;
+	}
+	return true;
+}
+
+void SharedMemoryTracker::ShutdownTracking()
+{
+	if(m_thread)
+	{
+		m_thread->Join();
+		delete m_thread;
+		m_thread = NULL;
+	}
+
+	if(m_ring)
+		UnmapViewOfFile(m_ring);
+	if(m_mapping)
+		CloseHandle(m_mapping);
+	if(m_event)
+		CloseHandle(m_event);
+
+	m_ring = NULL;
+	m_mapping = NULL;
+	m_event = NULL;
+}
+
+// Copies the record out, returning false if the writer has reused its slot
+// while it was being copied
+bool SharedMemoryTracker::ReadRecord(LONG sequence, HeadPoseRecord &record)
+{
+	record = m_ring->records[sequence & HEADPOSE_RING_MASK];
+	MemoryBarrier();
+
+	return record.sequence == (unsigned int)sequence && 
+			m_ring->written - sequence < HEADPOSE_RING_SIZE;
+}
+
+void SharedMemoryTracker::Publish(const HeadPoseRecord &record)
+{
+	FaceAPIData &data = GetWriteData();
+	UTIL_SetHeadPose(data, record.pose);
+	data.h_confidence = record.confidence;
+	data.h_frameNum = record.sequence + 1;	// 0 means no data
+
+	// the pose's age on arrival, carried over to the game's clock
+	data.h_time = ENGINE_NOW - (float)max(HeadPoseTimestamp() - record.timestamp, 0.0);
+
+	PublishData();
+}
+
+void SharedMemoryTracker::WaitForWriterOrStop(DWORD timeoutMs)
+{
+	HANDLE events[2] = { m_event, GetStopEvent() };
+	WaitForMultipleObjects(2, events, FALSE, timeoutMs);
+}
+
+// Spins for a little while before sleeping, so a tracker that is streaming
+// never costs a system call on either side
+void SharedMemoryTracker::WaitForWriter(LONG next)
+{
+	for(int i = 0; i < SHM_SPIN_COUNT; i++)
+	{
+		if(m_ring->written != next || IsStopping())
+			return;
+		ThreadPause();
+	}
+
+	InterlockedExchange(&m_ring->readerWaiting, 1);
+	if(m_ring->written == next)
+		WaitForWriterOrStop(SHM_MAX_WAIT_MS);
+	InterlockedExchange(&m_ring->readerWaiting, 0);
+}
+
+void SharedMemoryTracker::Read()
+{
+	LONG next = 0;
+
+	while(!IsStopping())
+	{
+		if(m_ring->magic != HEADPOSE_SHM_MAGIC || m_ring->version != HEADPOSE_SHM_VERSION || m_ring->recordSize != sizeof(HeadPoseRecord))
+		{
+			// no tracker yet (or an incompatible one)
+			WaitForWriterOrStop(SHM_MAX_WAIT_MS);
+			continue;
+		}
+
+		LONG written = m_ring->written;
+		if(written == next || written == 0)
+		{
+			WaitForWriter(written);
+			next = written;
+			continue;
+		}
+
+		// The game only picks up the newest pose, so anything older is
+		// skipped. A restarted tracker simply starts again from zero
+		HeadPoseRecord record;
+		if(ReadRecord(written - 1, record))
+			Publish(record);
+		next = written;
+	}
+}
@@ -0,0 +1,170 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_SHM_TRACKER_H
+#define HAL_SHM_TRACKER_H
+
+// The layout of the shared memory read by the "shm" tracker. This header has
+// no other dependencies, so an external tracker can include it as it is.
+//
+// The memory is a fixed header followed by a ring of records. There is a
+// single writer (the tracker) and a single reader (the game):
+//
+//	1.	the writer fills in records[written % HEADPOSE_RING_SIZE], including
+//		its sequence number (the value of written)
+//	2.	then increments written
+//	3.	and if readerWaiting is set, clears it and signals the event
+//
+// The writer never waits on the reader. The reader copies a record and then
+// checks that written hasn't moved on far enough to have reused its slot in
+// the meantime, which means it doesn't need a lock either. The reader only
+// sleeps on the event once it has found nothing new for a while, so there are
+// no system calls while the poses are streaming in.
+//
+// Timestamps are in seconds from QueryPerformanceCounter, so the reader can
+// tell how old each pose was when it arrived.
+
+#include <windows.h>
+
+#define HEADPOSE_SHM_NAME		"Local\\HALHeadPose"
+#define HEADPOSE_SHM_EVENT		"Local\\HALHeadPoseEvent"
+#define HEADPOSE_SHM_MAGIC		0x504C4148	// "HALP"
+#define HEADPOSE_SHM_VERSION	1
+
+// Must be a power of two
+#define HEADPOSE_RING_SIZE		64
+#define HEADPOSE_RING_MASK		(HEADPOSE_RING_SIZE - 1)
+
+// The indices of HeadPoseRecord::pose, which is the common 6 x double layout
+// used by the UDP tracker as well
+#define HEADPOSE_X		0	// cm, to the camera's right
+#define HEADPOSE_Y		1	// cm, up
+#define HEADPOSE_Z		2	// cm, away from the camera
+#define HEADPOSE_YAW	3	// degrees
+#define HEADPOSE_PITCH	4	// degrees
+#define HEADPOSE_ROLL	5	// degrees
+
+#pragma pack(push, 8)
+
+struct HeadPoseRecord
+{
+	double			timestamp;		// QueryPerformanceCounter seconds
+	double			pose[6];		// HEADPOSE_*
+	float			confidence;		// 0 (lost) to 1
+	unsigned int	sequence;		// the value of written for this record
+};
+
+struct HeadPoseRing
+{
+	unsigned int			magic;			// HEADPOSE_SHM_MAGIC
+	unsigned int			version;		// HEADPOSE_SHM_VERSION
+	unsigned int			recordSize;		// sizeof(HeadPoseRecord)
+	unsigned int			recordCount;	// HEADPOSE_RING_SIZE
+	float					nativeRate;		// samples per second, 0 if unknown
+	unsigned int			writerProcess;	// for information only
+
+	volatile LONG			written;		// the number of records written
+	volatile LONG			readerWaiting;	// set by the reader before it sleeps
+
+	HeadPoseRecord			records[HEADPOSE_RING_SIZE];
+};
+
+#pragma pack(pop)
+
+
+inline double HeadPoseTimestamp()
+{
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+
+
+// The writing side, for a tracker (or a test program) to use
+class HeadPoseRingWriter
+{
+public:
+	HeadPoseRingWriter() : m_mapping(NULL), m_event(NULL), m_ring(NULL) {}
+	~HeadPoseRingWriter() { Close(); }
+
+	bool Open(float nativeRate)
+	{
+		m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(HeadPoseRing), HEADPOSE_SHM_NAME);
+		m_event = CreateEventA(NULL, FALSE, FALSE, HEADPOSE_SHM_EVENT);
+		if(!m_mapping || !m_event)
+		{
+			Close();
+			return false;
+		}
+
+		m_ring = (HeadPoseRing*)MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(HeadPoseRing));
+		if(!m_ring)
+		{
+			Close();
+			return false;
+		}
+
+		// a new writer starts the sequence again, which the reader notices
+		m_ring->version		= HEADPOSE_SHM_VERSION;
+		m_ring->recordSize	= sizeof(HeadPoseRecord);
+		m_ring->recordCount	= HEADPOSE_RING_SIZE;
+		m_ring->nativeRate	= nativeRate;
+		m_ring->writerProcess = GetCurrentProcessId();
+		m_ring->written		= 0;
+		MemoryBarrier();
+		m_ring->magic		= HEADPOSE_SHM_MAGIC;
+		return true;
+	}
+
+	void Close()
+	{
+		if(m_ring)
+		{
+			m_ring->magic = 0;
+			UnmapViewOfFile(m_ring);
+		}
+		if(m_mapping)
+			CloseHandle(m_mapping);
+		if(m_event)
+			CloseHandle(m_event);
+
+		m_ring = NULL;
+		m_mapping = NULL;
+		m_event = NULL;
+	}
+
+	void Write(const double pose[6], float confidence, double timestamp = HeadPoseTimestamp())
+	{
+		LONG sequence = m_ring->written;
+		HeadPoseRecord &record = m_ring->records[sequence & HEADPOSE_RING_MASK];
+
+		record.timestamp = timestamp;
+		for(int i = 0; i < 6; i++)
+			record.pose[i] = pose[i];
+		record.confidence = confidence;
+		record.sequence = sequence;
+
+		InterlockedExchange(&m_ring->written, sequence + 1);
+
+		if(m_ring->readerWaiting && InterlockedExchange(&m_ring->readerWaiting, 0))
+			SetEvent(m_event);
+	}
+
+private:
+	HANDLE			m_mapping;
+	HANDLE			m_event;
+	HeadPoseRing	*m_ring;
+};
+
+#endif
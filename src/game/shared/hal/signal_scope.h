@@ -0,0 +1,87 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_SIGNAL_SCOPE_H
+#define HAL_SIGNAL_SCOPE_H
+
+#include "tier0/threadtools.h"
+#include "hal/pose_interpolation.h"
+
+// Must be a power of two. At 60 samples a second this holds around 30 seconds
+#define SIGNAL_SCOPE_SIZE	2048
+#define SIGNAL_SCOPE_MASK	(SIGNAL_SCOPE_SIZE - 1)
+#define SIGNAL_RAW_CHANNELS	6
+
+
+// Everything the filter graph saw and produced for a single tracker sample
+class SignalSample
+{
+public:
+	float	time;
+	float	raw[SIGNAL_RAW_CHANNELS];	// indexed by FACEAPI_*
+	float	leanInput;					// the lean before it is smoothed, eased and faded
+	float	confidence;
+	float	adapt;						// the adaptive smoothing factor
+	float	filtered[POSE_CHANNELS];	// indexed by FILTER_*
+};
+
+
+// A single-writer ring of the most recent samples. The writer never waits on
+// the readers: a reader copies what it wants and then drops anything that was
+// overwritten while it was copying.
+class SignalRing
+{
+public:
+	SignalRing() : m_written(0) {}
+
+	void Push(const SignalSample &sample)
+	{
+		m_samples[m_written & SIGNAL_SCOPE_MASK] = sample;
+		ThreadInterlockedIncrement(&m_written); // publishes the sample
+	}
+
+	// Copies the samples from the given time onwards, oldest first
+	int Read(float since, SignalSample *out, int maxSamples) const
+	{
+		long end = m_written;
+		long start = max(end - min(maxSamples, SIGNAL_SCOPE_SIZE), 0);
+
+		int count = 0;
+		for(long i = start; i < end; i++)
+		{
+			const SignalSample &sample = m_samples[i & SIGNAL_SCOPE_MASK];
+			if(sample.time >= since)
+				out[count++] = sample;
+		}
+
+		// Anything the writer has since lapped may be torn. The samples that
+		// were too old were all skipped from the front
+		long skipped = (end - start) - count;
+		long lapped = (m_written - SIGNAL_SCOPE_SIZE) - start - skipped;
+		if(lapped > 0)
+		{
+			lapped = min(lapped, (long)count);
+			memmove(out, out + lapped, (count - lapped) * sizeof(SignalSample));
+			count -= lapped;
+		}
+		return count;
+	}
+
+private:
+	SignalSample	m_samples[SIGNAL_SCOPE_SIZE];
+	volatile long	m_written;
+};
+
+SignalRing* UTIL_GetSignalRing();
+
+#endif
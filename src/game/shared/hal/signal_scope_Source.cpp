@@ -0,0 +1,212 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+#include "hud.h"
+#include "hudelement.h"
+#include "iclientmode.h"
+#include "filesystem.h"
+#include <vgui_controls/Panel.h>
+#include <vgui/ISurface.h>
+
+#include "hal/hal.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+ConVar hal_scope("hal_scope", "0", 0, "Shows the raw and filtered head data over the last few seconds");
+ConVar hal_scopeSeconds("hal_scopeSeconds", "5", FCVAR_ARCHIVE, "How many seconds the scope (and hal_scopeDump) covers", true, 1, true, 30);
+
+#define SCOPE_LANES			7
+#define SCOPE_NONE			-1
+#define SCOPE_LEAN_INPUT	-2	// the lean has no single raw channel
+
+// Each lane shows one raw input against what the filters made of it. The
+// last lane shows the tracking confidence and the adaptive smoothing. The
+// depth isn't filtered, so it only appears in the dump
+class ScopeLane
+{
+public:
+	const char	*name;
+	int			raw;		// FACEAPI_* or SCOPE_*
+	int			filtered;	// FILTER_*
+};
+
+static const ScopeLane s_lanes[SCOPE_LANES] =
+{
+	{ "roll",	FACEAPI_ROLL,	FILTER_ROLL },
+	{ "pitch",	FACEAPI_PITCH,	FILTER_PITCH },
+	{ "yaw",	FACEAPI_YAW,	FILTER_YAW },
+	{ "vert",	FACEAPI_VERT,	FILTER_VERT },
+	{ "sidew",	FACEAPI_SIDEW,	FILTER_SIDEW },
+	{ "lean",	SCOPE_LEAN_INPUT,	FILTER_LEAN },
+	{ "conf",	SCOPE_NONE,		SCOPE_NONE },
+};
+
+// Shared by the overlay and the dump, as they're both on the main thread
+static SignalSample	s_samples[SIGNAL_SCOPE_SIZE];
+static int			s_pointsX[SIGNAL_SCOPE_SIZE];
+static int			s_pointsY[SIGNAL_SCOPE_SIZE];
+
+
+class CHudHeadScope : public CHudElement, public vgui::Panel
+{
+	DECLARE_CLASS_SIMPLE(CHudHeadScope, vgui::Panel);
+
+public:
+	CHudHeadScope(const char *pElementName);
+
+	bool	ShouldDraw();
+	void	ApplySchemeSettings(vgui::IScheme *scheme);
+	void	Paint();
+
+private:
+	void	DrawChannel(int count, int lane, float (*getValue)(const SignalSample&, int), int index, Color color);
+
+	float	m_start;
+	float	m_seconds;
+	int		m_laneHeight;
+};
+
+DECLARE_HUDELEMENT(CHudHeadScope);
+
+CHudHeadScope::CHudHeadScope(const char *pElementName)
+	: CHudElement(pElementName), BaseClass(NULL, "HudHeadScope")
+{
+	SetParent(g_pClientMode->GetViewport());
+	m_start = 0;
+	m_seconds = 1;
+	m_laneHeight = 1;
+}
+
+void CHudHeadScope::ApplySchemeSettings(vgui::IScheme *scheme)
+{
+	BaseClass::ApplySchemeSettings(scheme);
+	SetPaintBackgroundEnabled(false);
+
+	// the lower left quarter of the screen
+	SetBounds(0, ScreenHeight() / 2, ScreenWidth() / 2, ScreenHeight() / 2);
+}
+
+bool CHudHeadScope::ShouldDraw()
+{
+	return hal_scope.GetBool() && UTIL_GetSignalRing() && CHudElement::ShouldDraw();
+}
+
+static float GetRaw(const SignalSample &sample, int index)		{ return (index == SCOPE_LEAN_INPUT) ? sample.leanInput : sample.raw[index]; }
+static float GetFiltered(const SignalSample &sample, int index)	{ return sample.filtered[index]; }
+static float GetConfidence(const SignalSample &sample, int)		{ return sample.confidence; }
+static float GetAdapt(const SignalSample &sample, int)			{ return sample.adapt; }
+
+// Each channel is scaled to fill its lane and drawn as a single line strip
+void CHudHeadScope::DrawChannel(int count, int lane, float (*getValue)(const SignalSample&, int), int index, Color color)
+{
+	float low = FLT_MAX, high = -FLT_MAX;
+	for(int i = 0; i < count; i++)
+	{
+		float value = getValue(s_samples[i], index);
+		low = min(low, value);
+		high = max(high, value);
+	}
+
+	float range = max(high - low, 0.0001f);
+	int wide = GetWide();
+	int bottom = (lane + 1) * m_laneHeight - 2;
+
+	for(int i = 0; i < count; i++)
+	{
+		s_pointsX[i] = (int)((s_samples[i].time - m_start) / m_seconds * wide);
+		s_pointsY[i] = bottom - (int)((getValue(s_samples[i], index) - low) / range * (m_laneHeight - 4));
+	}
+
+	vgui::surface()->DrawSetColor(color);
+	vgui::surface()->DrawPolyLine(s_pointsX, s_pointsY, count);
+}
+
+void CHudHeadScope::Paint()
+{
+	SignalRing *ring = UTIL_GetSignalRing();
+	if(!ring)
+		return;
+
+	m_seconds		= hal_scopeSeconds.GetFloat();
+	m_start			= ENGINE_NOW - m_seconds;
+	m_laneHeight	= GetTall() / SCOPE_LANES;
+
+	int count = ring->Read(m_start, s_samples, SIGNAL_SCOPE_SIZE);
+	if(count < 2)
+		return;
+
+	Color raw(255, 160, 0, 160);
+	Color filtered(0, 255, 128, 255);
+
+	for(int lane = 0; lane < SCOPE_LANES; lane++)
+	{
+		vgui::surface()->DrawSetColor(Color(255, 255, 255, 32));
+		vgui::surface()->DrawLine(0, (lane + 1) * m_laneHeight - 1, GetWide(), (lane + 1) * m_laneHeight - 1);
+
+		if(s_lanes[lane].raw == SCOPE_NONE)
+		{
+			DrawChannel(count, lane, &GetConfidence, 0, raw);
+			DrawChannel(count, lane, &GetAdapt, 0, filtered);
+		}
+		else
+		{
+			DrawChannel(count, lane, &GetRaw, s_lanes[lane].raw, raw);
+			DrawChannel(count, lane, &GetFiltered, s_lanes[lane].filtered, filtered);
+		}
+	}
+}
+
+
+// Writes the same data out for plotting elsewhere. This works whether or not
+// the scope is showing, so it can be used during a performance run
+CON_COMMAND(hal_scopeDump, "Writes the last hal_scopeSeconds of head data to a CSV file (default: hal_scope.csv)")
+{
+	SignalRing *ring = UTIL_GetSignalRing();
+	if(!ring)
+		return;
+
+	const char *fileName = (args.ArgC() > 1) ? args[1] : "hal_scope.csv";
+	FileHandle_t f = filesystem->Open(fileName, "w", "MOD");
+	if(!f)
+	{
+		Warning("Unable to write %s\n", fileName);
+		return;
+	}
+
+	int count = ring->Read(ENGINE_NOW - hal_scopeSeconds.GetFloat(), s_samples, SIGNAL_SCOPE_SIZE);
+
+	filesystem->FPrintf(f, "time,confidence,adapt");
+	for(int lane = 0; lane < SCOPE_LANES; lane++)
+	{
+		if(s_lanes[lane].raw != SCOPE_NONE)
+			filesystem->FPrintf(f, ",raw_%s,%s", s_lanes[lane].name, s_lanes[lane].name);
+	}
+	filesystem->FPrintf(f, ",raw_depth\n");
+
+	for(int i = 0; i < count; i++)
+	{
+		const SignalSample &sample = s_samples[i];
+		filesystem->FPrintf(f, "%.4f,%.3f,%.3f", sample.time, sample.confidence, sample.adapt);
+		for(int lane = 0; lane < SCOPE_LANES; lane++)
+		{
+			if(s_lanes[lane].raw != SCOPE_NONE)
+				filesystem->FPrintf(f, ",%.3f,%.3f", GetRaw(sample, s_lanes[lane].raw), sample.filtered[s_lanes[lane].filtered]);
+		}
+		filesystem->FPrintf(f, ",%.3f\n", sample.raw[FACEAPI_DEPTH]);
+	}
+
+	filesystem->Close(f);
+	Msg("Wrote %d samples to %s\n", count, fileName);
+}
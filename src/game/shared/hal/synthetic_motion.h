@@ -0,0 +1,228 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_SYNTHETIC_MOTION_H
+#define HAL_SYNTHETIC_MOTION_H
+
+// Generates a stream of head poses procedurally, for testing the filters and
+// the leaning without a camera (or a person). The same seed and settings
+// always give the same stream, whatever speed it is played back at.
+//
+// Like shm_tracker.h this has no other dependencies, so the test programs
+// can use it as well as the "synthetic" tracker
+
+#include <math.h>
+
+#define SYNTH_PI			3.14159265358979
+
+// the poses use the HEADPOSE_* layout: x, y, z (cm) then yaw, pitch, roll
+#define SYNTH_X				0
+#define SYNTH_Y				1
+#define SYNTH_Z				2
+#define SYNTH_YAW			3
+#define SYNTH_PITCH			4
+#define SYNTH_ROLL			5
+
+#define SYNTH_EASE_TIME		0.5		// seconds taken to get in or out of a lean
+#define SYNTH_NOD_TIME		0.8		// seconds
+#define SYNTH_DEPTH			60.0	// cm from the camera
+
+
+class SyntheticMotionSettings
+{
+public:
+	SyntheticMotionSettings()
+		: seed(1), frameRate(30), frameJitter(0.1f), slowFramesPerMinute(6), breathing(1),
+		leansPerMinute(6), leanOffset(12), leanRoll(15), nodsPerMinute(4), nodPitch(10), jitter(0.3f),
+		collapsesPerMinute(1), dropoutsPerMinute(1), dropoutLength(1) {}
+
+	unsigned int	seed;
+	float			frameRate;				// camera frames a second
+	float			frameJitter;			// the random variation of each frame's interval, as a fraction
+	float			slowFramesPerMinute;	// frames that take 2-4 times as long
+	float			breathing;				// the scale of the idle sway
+	float			leansPerMinute;
+	float			leanOffset;				// cm, for a full lean
+	float			leanRoll;				// degrees, for a full lean
+	float			nodsPerMinute;
+	float			nodPitch;				// degrees
+	float			jitter;					// the deviation of the frame to frame noise, in cm or degrees
+	float			collapsesPerMinute;		// periods of low confidence
+	float			dropoutsPerMinute;		// periods without any tracking
+	float			dropoutLength;			// seconds, for the longest dropout
+};
+
+
+class SyntheticSample
+{
+public:
+	double			time;		// seconds from the start of the stream
+	double			pose[6];	// SYNTH_*
+	float			confidence;
+};
+
+
+class SyntheticMotion
+{
+public:
+	SyntheticMotion() { Reset(SyntheticMotionSettings()); }
+
+	void Reset(const SyntheticMotionSettings &settings)
+	{
+		m_settings	= settings;
+		m_random	= settings.seed ? settings.seed : 1;
+		m_time		= 0;
+
+		m_lean.Schedule(0, NextInterval(settings.leansPerMinute));
+		m_nod.Schedule(0, NextInterval(settings.nodsPerMinute));
+		m_collapse.Schedule(0, NextInterval(settings.collapsesPerMinute));
+		m_dropout.Schedule(0, NextInterval(settings.dropoutsPerMinute));
+	}
+
+	// Produces the next camera frame
+	void Next(SyntheticSample &sample)
+	{
+		m_time += NextFrameInterval();
+		double t = m_time;
+
+		// starts any events that are due. Each draws from the random stream
+		// in a fixed order, which keeps the stream reproducible
+		if(m_lean.Update(t))
+		{
+			m_lean.Start(t, 1.5 + 2.5 * Random(), (Random() < 0.5f ? -1 : 1) * (0.5f + 0.5f * Random()));
+			m_lean.Schedule(m_lean.end, NextInterval(m_settings.leansPerMinute));
+		}
+		if(m_nod.Update(t))
+		{
+			m_nod.Start(t, SYNTH_NOD_TIME, 0.5f + 0.5f * Random());
+			m_nod.Schedule(m_nod.end, NextInterval(m_settings.nodsPerMinute));
+		}
+		if(m_collapse.Update(t))
+		{
+			m_collapse.Start(t, 0.5 + 2.5 * Random(), 0.2f + 0.3f * Random());
+			m_collapse.Schedule(m_collapse.end, NextInterval(m_settings.collapsesPerMinute));
+		}
+		if(m_dropout.Update(t))
+		{
+			m_dropout.Start(t, m_settings.dropoutLength * (0.1f + 0.9f * Random()), 0);
+			m_dropout.Schedule(m_dropout.end, NextInterval(m_settings.dropoutsPerMinute));
+		}
+
+		// breathing, plus a slow sway and drift
+		double breathing = m_settings.breathing;
+		double breath = sin(t * 2 * SYNTH_PI * 0.25);
+		sample.pose[SYNTH_X]		= breathing * 0.8 * sin(t * 2 * SYNTH_PI * 0.07);
+		sample.pose[SYNTH_Y]		= breathing * 0.4 * breath;
+		sample.pose[SYNTH_Z]		= SYNTH_DEPTH + breathing * 0.3 * breath;
+		sample.pose[SYNTH_YAW]		= breathing * 2.0 * sin(t * 2 * SYNTH_PI * 0.05);
+		sample.pose[SYNTH_PITCH]	= breathing * 0.6 * breath;
+		sample.pose[SYNTH_ROLL]		= breathing * 0.5 * sin(t * 2 * SYNTH_PI * 0.09);
+
+		// a lean moves the head sideways and tilts it
+		double lean = m_lean.Ease(t, SYNTH_EASE_TIME) * m_lean.amount;
+		sample.pose[SYNTH_X]		+= lean * m_settings.leanOffset;
+		sample.pose[SYNTH_ROLL]		-= lean * m_settings.leanRoll;
+		sample.pose[SYNTH_Y]		-= fabs(lean) * 0.2 * m_settings.leanOffset;
+
+		if(m_nod.IsActive(t))
+			sample.pose[SYNTH_PITCH] += m_nod.amount * m_settings.nodPitch * sin(m_nod.Progress(t) * SYNTH_PI);
+
+		for(int i = 0; i < 6; i++)
+			sample.pose[i] += m_settings.jitter * RandomGaussian();
+
+		sample.confidence = (float)(0.9 - 0.05 * fabs(RandomGaussian()));
+		if(m_collapse.IsActive(t))
+			sample.confidence = m_collapse.amount;
+		if(m_dropout.IsActive(t))
+			sample.confidence = 0;
+
+		sample.time = t;
+	}
+
+private:
+	// An occasional event, such as a lean. The next one is scheduled as soon
+	// as the current one has started
+	class Event
+	{
+	public:
+		Event() : start(0), end(0), next(0), amount(0) {}
+
+		void Schedule(double after, double interval) { next = after + interval; }
+		void Start(double t, double duration, float eventAmount) { start = t; end = t + duration; amount = eventAmount; }
+
+		// returns true when the next event is due to start
+		bool Update(double t) { return t >= next; }
+
+		bool IsActive(double t) const { return t >= start && t < end; }
+		double Progress(double t) const { return IsActive(t) ? (t - start) / (end - start) : 0; }
+
+		// 0 to 1 and back, easing in and out over the given time
+		double Ease(double t, double easeTime) const
+		{
+			if(!IsActive(t))
+				return 0;
+
+			double p = (t - start < end - t) ? t - start : end - t;
+			p = (p < easeTime) ? p / easeTime : 1;
+			return p * p * (3 - 2 * p);
+		}
+
+		double	start;
+		double	end;
+		double	next;
+		float	amount;
+	};
+
+	// xorshift, so the stream doesn't depend on the runtime's rand()
+	float Random()
+	{
+		m_random ^= m_random << 13;
+		m_random ^= m_random >> 17;
+		m_random ^= m_random << 5;
+		return (m_random >> 8) * (1.0f / 16777216.0f);
+	}
+
+	float RandomGaussian()
+	{
+		float u = Random() + 1.0f / 16777216.0f;
+		float v = Random();
+		return (float)(sqrt(-2 * log(u)) * cos(2 * SYNTH_PI * v));
+	}
+
+	// The time to the next event, as if they happen at random at the given rate
+	double NextInterval(float perMinute)
+	{
+		if(perMinute <= 0)
+			return 1e30;
+		return -log(1 - Random()) * 60 / perMinute;
+	}
+
+	double NextFrameInterval()
+	{
+		double interval = (1 + m_settings.frameJitter * (2 * Random() - 1)) / m_settings.frameRate;
+		if(Random() < m_settings.slowFramesPerMinute / (60 * m_settings.frameRate))
+			interval *= 2 + 2 * Random();
+		return interval;
+	}
+
+	SyntheticMotionSettings	m_settings;
+	unsigned int			m_random;
+	double					m_time;
+
+	Event					m_lean;
+	Event					m_nod;
+	Event					m_collapse;
+	Event					m_dropout;
+};
+
+#endif
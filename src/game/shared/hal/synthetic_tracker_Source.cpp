@@ -0,0 +1,181 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+#include "filesystem.h"
+#include "tier0/threadtools.h"
+
+#include "hal/head_tracker.h"
+#include "hal/synthetic_motion.h"
+#include "hal/engine_dependencies.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+ConVar hal_synthSeed("hal_synthSeed", "1", 0, "The seed of the synthetic head motion");
+ConVar hal_synthRate("hal_synthRate", "30", 0, "Synthetic camera frames a second", true, 1, true, 1000);
+ConVar hal_synthLeans("hal_synthLeans", "6", 0, "Synthetic leans a minute", true, 0, false, 0);
+ConVar hal_synthNods("hal_synthNods", "4", 0, "Synthetic nods a minute", true, 0, false, 0);
+ConVar hal_synthJitter("hal_synthJitter", "0.3", 0, "The frame to frame noise of the synthetic motion (cm or degrees)", true, 0, false, 0);
+ConVar hal_synthCollapses("hal_synthCollapses", "1", 0, "Synthetic periods of low confidence a minute", true, 0, false, 0);
+ConVar hal_synthDropouts("hal_synthDropouts", "1", 0, "Synthetic tracking dropouts a minute", true, 0, false, 0);
+
+
+static SyntheticMotionSettings GetSettings()
+{
+	SyntheticMotionSettings settings;
+	settings.seed				= (unsigned int)hal_synthSeed.GetInt();
+	settings.frameRate			= hal_synthRate.GetFloat();
+	settings.leansPerMinute		= hal_synthLeans.GetFloat();
+	settings.nodsPerMinute		= hal_synthNods.GetFloat();
+	settings.jitter				= hal_synthJitter.GetFloat();
+	settings.collapsesPerMinute	= hal_synthCollapses.GetFloat();
+	settings.dropoutsPerMinute	= hal_synthDropouts.GetFloat();
+	return settings;
+}
+
+static void ToHeadData(const SyntheticSample &sample, FaceAPIData &data)
+{
+	UTIL_SetHeadPose(data, sample.pose);
+	data.h_confidence = sample.confidence;
+}
+
+
+// Plays the synthetic motion (see synthetic_motion.h) in real time, so the
+// game can be left running against it
+class SyntheticTracker: public HeadTrackerBackend
+{
+public:
+	SyntheticTracker() : m_thread(NULL) {}
+
+	const char*		GetName() { return "synthetic"; }
+	int				GetCapabilities() { return TRACKER_ROTATION | TRACKER_POSITION | TRACKER_CONFIDENCE | TRACKER_TIMESTAMPS; }
+	float			GetNativeRate() { return hal_synthRate.GetFloat(); }
+
+	void			Generate();
+
+protected:
+	bool			InitTracking();
+	void			ShutdownTracking();
+
+private:
+	class GeneratorThread: public CThread
+	{
+	public:
+		GeneratorThread(SyntheticTracker *tracker) : m_tracker(tracker) {}
+		int Run() { m_tracker->Generate(); return 0; }
+
+	private:
+		SyntheticTracker *m_tracker;
+	};
+
+	SyntheticMotion	m_motion;
+	GeneratorThread	*m_thread;
+};
+
+REGISTER_HEAD_TRACKER(SyntheticTracker, "synthetic", "Generates head motion from hal_synthSeed (see hal_synth*)");
+
+
+bool SyntheticTracker::InitTracking()
+{
+	m_motion.Reset(GetSettings());
+
+	m_thread = new GeneratorThread(this);
+	if(!m_thread->Start())
+	{
+		delete m_thread;
+		m_thread = NULL;
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to start the generator thread");
+		return false;
+	}
+	return true;
+}
+
+void SyntheticTracker::ShutdownTracking()
+{
+	if(!m_thread)
+		return;
+
+	m_thread->Join();
+	delete m_thread;
+	m_thread = NULL;
+}
+
+void SyntheticTracker::Generate()
+{
+	float start = ENGINE_NOW;
+
+	SyntheticSample sample;
+	m_motion.Next(sample);
+
+	while(!IsStopping())
+	{
+		float wait = start + sample.time - ENGINE_NOW;
+		if(wait > 0)
+		{
+			WaitForStop(max((int)(wait * 1000), 1));
+			continue;
+		}
+
+		FaceAPIData &data = GetWriteData();
+		ToHeadData(sample, data);
+		data.h_time = start + sample.time;
+		PublishData();
+
+		m_motion.Next(sample);
+	}
+}
+
+
+// Writes the motion out as a recording for the replay tracker, as fast as it
+// can be generated. Comparing filter settings against the same file means
+// they all see exactly the same input
+CON_COMMAND(hal_synthWrite, "Writes synthetic head motion to a recording: hal_synthWrite <file> <seconds>")
+{
+	if(args.ArgC() < 3)
+	{
+		Msg("Usage: hal_synthWrite <file> <seconds>\n");
+		return;
+	}
+
+	FileHandle_t f = filesystem->Open(args[1], "w", "MOD");
+	if(!f)
+	{
+		Warning("Unable to write %s\n", args[1]);
+		return;
+	}
+
+	SyntheticMotion motion;
+	motion.Reset(GetSettings());
+
+	double seconds = atof(args[2]);
+	int count = 0;
+
+	// the same columns as hal_scopeDump, less the filtered values
+	filesystem->FPrintf(f, "time,confidence,raw_roll,raw_pitch,raw_yaw,raw_vert,raw_sidew,raw_depth\n");
+
+	SyntheticSample sample;
+	for(motion.Next(sample); sample.time <= seconds; motion.Next(sample))
+	{
+		FaceAPIData data;
+		ToHeadData(sample, data);
+
+		filesystem->FPrintf(f, "%.4f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", sample.time, data.h_confidence,
+				data.h_headPos[FACEAPI_ROLL], data.h_headPos[FACEAPI_PITCH], data.h_headPos[FACEAPI_YAW],
+				data.h_headPos[FACEAPI_VERT], data.h_headPos[FACEAPI_SIDEW], data.h_headPos[FACEAPI_DEPTH]);
+		count++;
+	}
+
+	filesystem->Close(f);
+	Msg("Wrote %d samples to %s\n", count, args[1]);
+}
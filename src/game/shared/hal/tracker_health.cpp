@@ -0,0 +1,212 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+#include <KeyValues.h>
+#include "filesystem.h"
+
+#include "hal/hal.h"
+#include "hal/tracker_health.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+// How quickly the mean interval and jitter follow changes, per sample
+#define HEALTH_SMOOTHING	0.05f
+
+// Any longer and the gap counts as the tracking having stopped, rather than
+// a slow frame
+#define HEALTH_MAX_INTERVAL	1.0f
+
+static const float s_intervalBins[HEALTH_INTERVAL_BINS - 1] = { 10, 20, 30, 40, 50, 70, 100, 150, 250, 500 };
+
+
+void TrackerHealth::Reset()
+{
+	m_samples		= 0;
+	m_dropped		= 0;
+	m_duplicated	= 0;
+	m_restarts		= 0;
+
+	m_first			= 0;
+	m_last			= 0;
+	m_lastFrame		= 0;
+
+	m_meanInterval	= 0;
+	m_jitter		= 0;
+
+	m_trackedTime	= 0;
+	m_lowConfTime	= 0;
+	m_lostTime		= 0;
+
+	memset(m_intervals, 0, sizeof(m_intervals));
+	memset(m_confidence, 0, sizeof(m_confidence));
+}
+
+void TrackerHealth::Update(const FaceAPIData &data, float arrival, bool hasFrameNumbers, float lowConfidence)
+{
+	if(m_samples > 0)
+	{
+		if(hasFrameNumbers)
+		{
+			if(data.h_frameNum == m_lastFrame)
+				m_duplicated++;
+			else if(data.h_frameNum < m_lastFrame)
+				m_restarts++;
+			else
+				m_dropped += data.h_frameNum - m_lastFrame - 1;
+		}
+
+		float interval = arrival - m_last;
+		if(interval <= HEALTH_MAX_INTERVAL)
+		{
+			float ms = interval * 1000;
+			int bin = 0;
+			while(bin < HEALTH_INTERVAL_BINS - 1 && ms > s_intervalBins[bin])
+				bin++;
+			m_intervals[bin]++;
+
+			// the first interval seeds the mean, rather than easing in from 0
+			if(m_meanInterval == 0)
+				m_meanInterval = interval;
+
+			m_jitter += HEALTH_SMOOTHING * (fabs(interval - m_meanInterval) - m_jitter);
+			m_meanInterval += HEALTH_SMOOTHING * (interval - m_meanInterval);
+
+			m_trackedTime += interval;
+			if(data.h_confidence <= 0)
+				m_lostTime += interval;
+			else if(data.h_confidence < lowConfidence)
+				m_lowConfTime += interval;
+		}
+	}
+	else
+	{
+		m_first = arrival;
+	}
+
+	int bin = clamp((int)(data.h_confidence * HEALTH_CONF_BINS), 0, HEALTH_CONF_BINS - 1);
+	m_confidence[bin]++;
+
+	m_samples++;
+	m_last = arrival;
+	m_lastFrame = data.h_frameNum;
+}
+
+float TrackerHealth::GetRate() const
+{
+	return (m_meanInterval > 0) ? 1 / m_meanInterval : 0;
+}
+
+float TrackerHealth::GetJitter() const
+{
+	return m_jitter;
+}
+
+static float Percent(float part, float whole)
+{
+	return (whole > 0) ? 100 * part / whole : 0;
+}
+
+void TrackerHealth::Print(const char *name) const
+{
+	Msg("%s: %u samples over %.0f seconds\n", name, m_samples, m_last - m_first);
+	Msg("  rate:       %.1f a second (jitter %.1f ms)\n", GetRate(), GetJitter() * 1000);
+	Msg("  frames:     %u dropped, %u duplicated, %u restarts\n", m_dropped, m_duplicated, m_restarts);
+	Msg("  confidence: %.1f%% low, %.1f%% lost\n", Percent(m_lowConfTime, m_trackedTime), Percent(m_lostTime, m_trackedTime));
+
+	unsigned int intervals = 0;
+	for(int i = 0; i < HEALTH_INTERVAL_BINS; i++)
+		intervals += m_intervals[i];
+
+	Msg("  intervals:\n");
+	for(int i = 0; i < HEALTH_INTERVAL_BINS; i++)
+	{
+		if(i < HEALTH_INTERVAL_BINS - 1)
+			Msg("    <= %3.0f ms  %5.1f%%\n", s_intervalBins[i], Percent(m_intervals[i], intervals));
+		else
+			Msg("     > %3.0f ms  %5.1f%%\n", s_intervalBins[i - 1], Percent(m_intervals[i], intervals));
+	}
+
+	Msg("  confidence:\n");
+	for(int i = 0; i < HEALTH_CONF_BINS; i++)
+		Msg("    %.1f - %.1f  %5.1f%%\n", (float)i / HEALTH_CONF_BINS, (float)(i + 1) / HEALTH_CONF_BINS, Percent(m_confidence[i], m_samples));
+}
+
+void TrackerHealth::Write(KeyValues *kv) const
+{
+	kv->SetInt("samples", m_samples);
+	kv->SetFloat("seconds", m_last - m_first);
+	kv->SetFloat("rate", GetRate());
+	kv->SetFloat("jitter_ms", GetJitter() * 1000);
+	kv->SetInt("dropped", m_dropped);
+	kv->SetInt("duplicated", m_duplicated);
+	kv->SetInt("restarts", m_restarts);
+	kv->SetFloat("tracked_s", m_trackedTime);
+	kv->SetFloat("low_confidence_s", m_lowConfTime);
+	kv->SetFloat("lost_s", m_lostTime);
+
+	char name[32];
+	KeyValues *intervals = kv->FindKey("intervals_ms", true);
+	for(int i = 0; i < HEALTH_INTERVAL_BINS; i++)
+	{
+		if(i < HEALTH_INTERVAL_BINS - 1)
+			Q_snprintf(name, sizeof(name), "%.0f", s_intervalBins[i]);
+		else
+			Q_snprintf(name, sizeof(name), "more");
+		intervals->SetInt(name, m_intervals[i]);
+	}
+
+	KeyValues *confidence = kv->FindKey("confidence", true);
+	for(int i = 0; i < HEALTH_CONF_BINS; i++)
+	{
+		Q_snprintf(name, sizeof(name), "%.1f", (float)(i + 1) / HEALTH_CONF_BINS);
+		confidence->SetInt(name, m_confidence[i]);
+	}
+}
+
+
+CON_COMMAND(hal_trackerHealth, "Shows how well the head tracker is keeping up")
+{
+	HeadTrackerBackend *tracker = UTIL_GetHeadTracker();
+	if(!tracker)
+	{
+		Msg("No head tracker is running\n");
+		return;
+	}
+	tracker->GetHealth().Print(tracker->GetName());
+}
+
+// The same figures in a KeyValues file, for attaching to a bug report
+CON_COMMAND(hal_trackerHealthDump, "Writes the head tracker's health to a file (default: hal_tracker_health.txt)")
+{
+	HeadTrackerBackend *tracker = UTIL_GetHeadTracker();
+	if(!tracker)
+	{
+		Msg("No head tracker is running\n");
+		return;
+	}
+
+	const char *fileName = (args.ArgC() > 1) ? args[1] : "hal_tracker_health.txt";
+
+	KeyValues *kv = new KeyValues("TrackerHealth");
+	kv->SetString("tracker", tracker->GetName());
+	kv->SetFloat("native_rate", tracker->GetNativeRate());
+	tracker->GetHealth().Write(kv);
+
+	if(kv->SaveToFile(filesystem, fileName, "MOD"))
+		Msg("Wrote %s\n", fileName);
+	else
+		Warning("Unable to write %s\n", fileName);
+	kv->deleteThis();
+}
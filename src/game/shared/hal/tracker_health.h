@@ -0,0 +1,68 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_TRACKER_HEALTH_H
+#define HAL_TRACKER_HEALTH_H
+
+class FaceAPIData;
+class KeyValues;
+
+// The upper edges of the interval histogram, in milliseconds. The last bin
+// takes everything longer
+#define HEALTH_INTERVAL_BINS	11
+#define HEALTH_CONF_BINS		10
+
+
+// How well a tracker is keeping up: its rate, how evenly the samples arrive,
+// the frames it has dropped and how confident it is. Updated by the tracking
+// thread as each sample is published, at a fixed cost per sample. The game
+// only ever reads it for display, so it doesn't lock
+class TrackerHealth
+{
+public:
+	TrackerHealth() { Reset(); }
+
+	void	Reset();
+
+	// arrival is in ENGINE_NOW seconds, lowConfidence is the threshold below
+	// which the filters start smoothing more
+	void	Update(const FaceAPIData &data, float arrival, bool hasFrameNumbers, float lowConfidence);
+
+	float	GetRate() const;
+	float	GetJitter() const;	// the mean deviation of the intervals, in seconds
+
+	void	Print(const char *name) const;
+	void	Write(KeyValues *kv) const;
+
+private:
+	unsigned int	m_samples;
+	unsigned int	m_dropped;		// from the gaps in the frame numbers
+	unsigned int	m_duplicated;
+	unsigned int	m_restarts;		// the frame numbers went backwards
+
+	float			m_first;
+	float			m_last;
+	unsigned int	m_lastFrame;
+
+	float			m_meanInterval;	// exponentially weighted
+	float			m_jitter;
+
+	float			m_trackedTime;
+	float			m_lowConfTime;	// below lowConfidence
+	float			m_lostTime;		// no confidence at all
+
+	unsigned int	m_intervals[HEALTH_INTERVAL_BINS];
+	unsigned int	m_confidence[HEALTH_CONF_BINS];
+};
+
+#endif
@@ -0,0 +1,222 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+#include <winsock2.h>
+#include "tier0/threadtools.h"
+
+#include "hal/head_tracker.h"
+#include "hal/shm_tracker.h"
+#include "hal/engine_dependencies.h"
+#include "hal/data_filtering.h"
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+ConVar hal_udpPort("hal_udpPort", "4242", FCVAR_ARCHIVE, "The local port the UDP tracker listens on", true, 1, true, 65535);
+
+// The packet is the common 6 x double layout (see HEADPOSE_* in shm_tracker.h)
+#define UDP_PACKET_SIZE		(6 * sizeof(double))
+
+// The sender is taken to have stopped after this many of its packet intervals
+// go by without one (or hal_bridgeMax_s, whichever is shorter)
+#define UDP_STALE_PACKETS	3
+#define UDP_INTERVAL_RATE	0.05f
+
+
+// Receives poses sent over UDP by a tracker running on the same machine, in
+// the 6 x double layout that most head tracking software can already send
+class UDPTracker: public HeadTrackerBackend
+{
+public:
+	UDPTracker() : m_socket(INVALID_SOCKET), m_readEvent(WSA_INVALID_EVENT), m_thread(NULL), m_packets(0), m_rejected(0) {}
+
+	const char*		GetName() { return "udp"; }
+	int				GetCapabilities() { return TRACKER_ROTATION | TRACKER_POSITION; }
+	float			GetNativeRate() { return 0; }
+
+	void			Receive();
+
+protected:
+	bool			InitTracking();
+	void			ShutdownTracking();
+
+private:
+	class ReceiveThread: public CThread
+	{
+	public:
+		ReceiveThread(UDPTracker *tracker) : m_tracker(tracker) {}
+		int Run() { m_tracker->Receive(); return 0; }
+
+	private:
+		UDPTracker *m_tracker;
+	};
+
+	SOCKET			m_socket;
+	WSAEVENT		m_readEvent;
+	ReceiveThread	*m_thread;
+
+	unsigned int	m_packets;
+	unsigned int	m_rejected;
+};
+
+REGISTER_HEAD_TRACKER(UDPTracker, "udp", "Receives x, y, z, yaw, pitch, roll (6 doubles) on hal_udpPort");
+
+
+bool UDPTracker::InitTracking()
+{
+	WSADATA wsaData;
+	if(WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to start Winsock");
+		return false;
+	}
+
+	// only listen locally, as nothing is checked beyond the size of a packet
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family		= AF_INET;
+	address.sin_port		= htons((u_short)hal_udpPort.GetInt());
+	address.sin_addr.s_addr	= htonl(INADDR_LOOPBACK);
+
+	// the event also makes the socket non-blocking
+	m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	m_readEvent = WSACreateEvent();
+	if(m_socket == INVALID_SOCKET || m_readEvent == WSA_INVALID_EVENT ||
+			bind(m_socket, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+			WSAEventSelect(m_socket, m_readEvent, FD_READ) == SOCKET_ERROR)
+	{
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to listen on port %d (error %d)", hal_udpPort.GetInt(), WSAGetLastError());
+		ShutdownTracking();
+		return false;
+	}
+
+	m_thread = new ReceiveThread(this);
+	if(!m_thread->Start())
+	{
+		delete m_thread;
+		m_thread = NULL;
+		engine_sprintf(m_initError, sizeof(m_initError), "unable to start the receive thread");
+		ShutdownTracking();
+		return false;
+	}
+
+	engine_printf("Listening for head poses on port %d\n", hal_udpPort.GetInt());
+	return true;
+}
+
+void UDPTracker::ShutdownTracking()
+{
+	if(m_thread)
+	{
+		m_thread->Join();
+		delete m_thread;
+		m_thread = NULL;
+	}
+
+	if(m_socket != INVALID_SOCKET)
+		closesocket(m_socket);
+	if(m_readEvent != WSA_INVALID_EVENT)
+		WSACloseEvent(m_readEvent);
+	m_socket = INVALID_SOCKET;
+	m_readEvent = WSA_INVALID_EVENT;
+
+	WSACleanup();
+
+	if(m_packets > 0)
+		engine_printf("UDP tracker: %u packets, %u rejected\n", m_packets, m_rejected);
+}
+
+// Waits for the socket to become readable (or the tracker to be shut down)
+// and then drains it. Only the newest pose in each batch is published, as
+// that is all the game would pick up. There is no confidence in the packets,
+// so a sender that goes quiet is published as a pose with no confidence, which
+// lets the filters bridge and then fade it like any other drop-out
+void UDPTracker::Receive()
+{
+	double packet[64];	// room for anything larger, which is rejected
+	double newest[6];
+
+	float lastArrival = 0;
+	float interval = 0;
+	bool stale = true;	// nothing has arrived to go stale
+
+	HANDLE events[2] = { m_readEvent, GetStopEvent() };
+
+	for(;;)
+	{
+		DWORD timeout = INFINITE;
+		if(!stale)
+		{
+			float staleTime = hal_bridgeMax_s.GetFloat();
+			if(interval > 0)
+				staleTime = min(UDP_STALE_PACKETS * interval, staleTime);
+			timeout = (DWORD)max((int)(staleTime * 1000), 1);
+		}
+
+		DWORD result = WaitForMultipleObjects(2, events, FALSE, timeout);
+		if(result == WAIT_TIMEOUT)
+		{
+			FaceAPIData &data = GetWriteData();
+			UTIL_SetHeadPose(data, newest);
+			data.h_confidence	= 0.0f;
+			data.h_time			= lastArrival;
+			PublishData();
+
+			stale = true;
+			continue;
+		}
+		if(result != WAIT_OBJECT_0)
+			break;
+		WSAResetEvent(m_readEvent);
+
+		// taken straight after the wake up, as close to the arrival as we get
+		float arrival = ENGINE_NOW;
+		bool received = false;
+
+		for(;;)
+		{
+			int size = recv(m_socket, (char*)packet, sizeof(packet), 0);
+			if(size == SOCKET_ERROR && WSAGetLastError() != WSAEMSGSIZE)
+				break;	// WSAEWOULDBLOCK once it has been drained
+
+			m_packets++;
+			if(size != UDP_PACKET_SIZE)
+			{
+				m_rejected++;
+				continue;
+			}
+
+			memcpy(newest, packet, sizeof(newest));
+			received = true;
+		}
+
+		if(!received)
+			continue;
+
+		// the interval is only learnt while the packets are flowing, so the
+		// gaps themselves don't stretch it
+		float step = arrival - lastArrival;
+		if(!stale && step > 0)
+			interval = (interval > 0) ? interval + (step - interval) * UDP_INTERVAL_RATE : step;
+
+		lastArrival = arrival;
+		stale = false;
+
+		FaceAPIData &data = GetWriteData();
+		UTIL_SetHeadPose(data, newest);
+		data.h_confidence	= 1.0f;
+		data.h_time			= arrival;
+		PublishData();
+	}
+}
@@ -44,33 +44,114 @@ PARTICULAR PURPOSE.
 #include <vgui/ISurface.h>
 #include "ScreenSpaceEffects.h"
 // previous includes mirror those in view.cpp
+#include "baseviewmodel_shared.h"
+#include "c_basecombatweapon.h"
 
 #include "hal/util.h"
 
-ConVar hal_leanFOV("hal_leanFOV", "12", FCVAR_ARCHIVE);
+ConVar hal_lateLatch("hal_lateLatch", "1", FCVAR_ARCHIVE, "Re-reads the head pose just before the main view is rendered");
+
+extern ConVar hal_weapon_ease;
+extern ConVar hal_weapon_pullback;
+
+// CalcViewModelView has already placed the viewmodels using the earlier pose,
+// so they are moved by the difference that the latched pose makes to their
+// offset (see CBaseViewModel::CalcViewModelView). Running CalcViewModelView
+// again would step the bob and lag twice in the one frame
+static void RelatchViewModels(C_BasePlayer *pPlayer, const QAngle &eyeAngles, 
+							  float oldLean, float oldPitch, float newLean, float newPitch)
+{
+	matrix3x4_t eye;
+	AngleMatrix(eyeAngles, eye);
+
+	for(int i = 0; i < MAX_VIEWMODELS; i++)
+	{
+		C_BaseViewModel *vm = pPlayer->GetViewModel(i);
+		if(!vm || !vm->GetOwningWeapon())
+			continue;
+
+		const WeaponPoseTable &poses = vm->GetOwningWeapon()->GetWpnData().leanPoses;
+
+		Vector oldLocal, newLocal;
+		QAngle oldAngles, newAngles;
+		poses.Lookup(oldLean, oldPitch / -hal_weapon_pullback.GetFloat(), hal_weapon_ease.GetFloat(), oldLocal, oldAngles);
+		poses.Lookup(newLean, newPitch / -hal_weapon_pullback.GetFloat(), hal_weapon_ease.GetFloat(), newLocal, newAngles);
+
+		// the matrix's y axis points left
+		Vector local = newLocal - oldLocal;
+		Vector world;
+		VectorRotate(Vector(local.x, -local.y, local.z), eye, world);
+
+		vm->SetLocalOrigin(vm->GetLocalOrigin() + world);
+		vm->SetLocalAngles(vm->GetLocalAngles() + newAngles - oldAngles);
+	}
+}
 
 void CViewRender::ApplyHeadShake(CViewSetup *view)
 {
-	CameraOffsets shake = UTIL_GetHandycamShake();
+	// kept so the shake can be redone with a newer pose (see LateLatchHeadShake)
+	m_ViewWithoutHeadShake = *view;
+	m_bHeadShakeLatchPending = true;
+
+	ViewOffset offset = UTIL_GetViewOffset();
 
-	view->angles[PITCH]		-= shake.pitch;
-	view->angles[YAW]		+= shake.yaw;
-	view->angles[ROLL]		-= shake.roll;
-	
-	float width		=     CMS_TO_SOURCE(shake.horOff);
-	float height	= max(CMS_TO_SOURCE(shake.vertOff), 0);
+	matrix3x4_t eye, shaken;
+	AngleMatrix(view->angles, eye);
+	ConcatTransforms(eye, offset.rotation, shaken);
+	MatrixAngles(shaken, view->angles);
 
-	view->origin.y += width * cos(DEG_TO_RAD(view->angles[YAW]));
-	view->origin.x -= width * sin(DEG_TO_RAD(view->angles[YAW]));
-	view->origin.z += height;
+	// the side and vertical offsets only follow the (shaken) yaw
+	matrix3x4_t level;
+	Vector move;
+	AngleMatrix(QAngle(0, view->angles[YAW], 0), level);
+	VectorRotate(offset.position, level, move);
+	view->origin += move;
 
 	C_BasePlayer *pPlayer = C_BasePlayer::GetLocalPlayer();
 
 	if(pPlayer && pPlayer->IsAlive())
 	{
-		float aspectRatio	  = engine->GetScreenAspectRatio() * 0.75f;
-		float leanFov		  = fabs(UTIL_GetLeanAmount()) * hal_leanFOV.GetFloat() * aspectRatio;
-		view->fov			 -= leanFov;
-		view->fovViewmodel	 -= leanFov;
+		view->fov			-= offset.fovDelta;
+		view->fovViewmodel	-= offset.fovDelta;
+	}
+}
+// The shake is first applied at the start of CViewRender::Render, but a new
+// sample can arrive while the rest of the frame is being prepared. This swaps
+// the shake for the latest one as the last thing before the main view is set up
+void CViewRender::LateLatchHeadShake(CViewSetup *view)
+{
+	if(!m_bHeadShakeLatchPending)
+		return;
+
+	m_bHeadShakeLatchPending = false;
+
+	// what CalcViewModelView placed the viewmodels with
+	float oldLean	= UTIL_GetLeanAmount();
+	float oldPitch	= UTIL_GetHandycamShake().pitch;
+
+	if(!hal_lateLatch.GetBool() || !UTIL_LatchHeadPose())
+		return;
+
+	view->origin		= m_ViewWithoutHeadShake.origin;
+	view->angles		= m_ViewWithoutHeadShake.angles;
+	view->fov			= m_ViewWithoutHeadShake.fov;
+	view->fovViewmodel	= m_ViewWithoutHeadShake.fovViewmodel;
+
+	ApplyHeadShake(view);
+	m_bHeadShakeLatchPending = false;
+
+	// the rest of the frame reads the view from m_View as well
+	m_View.origin		= view->origin;
+	m_View.angles		= view->angles;
+	m_View.fov			= view->fov;
+	m_View.fovViewmodel	= view->fovViewmodel;
+
+	C_BasePlayer *pPlayer = C_BasePlayer::GetLocalPlayer();
+	if(pPlayer && pPlayer->IsAlive())
+	{
+		RelatchViewModels(pPlayer, m_ViewWithoutHeadShake.angles, 
+				oldLean, oldPitch, UTIL_GetLeanAmount(), UTIL_GetHandycamShake().pitch);
 	}
-}
\ No newline at end of file
+
+	render->SetMainView(view->origin, view->angles);
+}
@@ -0,0 +1,95 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+
+#include "hal/weapon_pose.h"
+
+// the ease the tables are first built with (see hal_weapon_ease)
+#define WEAPON_POSE_DEFAULT_EASE	2.0f
+
+
+static void BlendPose(const WeaponPose *table, int steps, float index, Vector &pos, QAngle &ang)
+{
+	int i = clamp((int)index, 0, steps - 1);
+	float f = index - i;
+
+	pos += table[i].pos + (table[i + 1].pos - table[i].pos) * f;
+	ang += table[i].ang + (table[i + 1].ang - table[i].ang) * f;
+}
+
+
+WeaponPoseTable::WeaponPoseTable()
+{
+	Init(vec3_origin, vec3_angle, vec3_origin, vec3_angle, vec3_origin, vec3_angle, vec3_origin, vec3_angle);
+}
+
+void WeaponPoseTable::Init(	const Vector &neutralPos,	const QAngle &neutralAng,
+							const Vector &leftPos,		const QAngle &leftAng,
+							const Vector &rightPos,		const QAngle &rightAng,
+							const Vector &retractPos,	const QAngle &retractAng )
+{
+	m_neutralPos	= neutralPos;
+	m_neutralAng	= neutralAng;
+	m_leftPos		= leftPos;
+	m_leftAng		= leftAng;
+	m_rightPos		= rightPos;
+	m_rightAng		= rightAng;
+
+	BuildLean(WEAPON_POSE_DEFAULT_EASE);
+
+	// the pull-back is eased in with a spline
+	for(int i = 0; i <= WEAPON_POSE_RETRACT_STEPS; i++)
+	{
+		float amount = SimpleSpline(i / (float)WEAPON_POSE_RETRACT_STEPS);
+		m_retract[i].pos = retractPos * amount;
+		m_retract[i].ang = retractAng * amount;
+	}
+}
+
+// Only the roll is eased, the position moves with the lean itself
+void WeaponPoseTable::BuildLean(float ease) const
+{
+	for(int i = 0; i <= 2 * WEAPON_POSE_LEAN_STEPS; i++)
+	{
+		float lean		= i / (float)WEAPON_POSE_LEAN_STEPS - 1;
+		float amount	= fabs(lean);
+		float eased		= pow(amount, ease);
+
+		const Vector &pos = (lean > 0.0f) ? m_leftPos : m_rightPos;
+		const QAngle &ang = (lean > 0.0f) ? m_leftAng : m_rightAng;
+
+		m_lean[i].pos			= m_neutralPos + pos * lean;
+		m_lean[i].ang			= m_neutralAng;
+		m_lean[i].ang[PITCH]	+= ang[PITCH]	* amount;
+		m_lean[i].ang[YAW]		+= ang[YAW]		* amount;
+		m_lean[i].ang[ROLL]		+= ang[ROLL]	* eased;
+	}
+
+	m_ease = ease;
+}
+
+void WeaponPoseTable::Lookup(float lean, float pullBack, float ease, Vector &pos, QAngle &ang) const
+{
+	if(ease != m_ease)
+		BuildLean(ease);
+
+	pos.Init();
+	ang.Init();
+
+	float leanIndex		= (clamp(lean, -1.0f, 1.0f) + 1.0f) * WEAPON_POSE_LEAN_STEPS;
+	float retractIndex	= clamp(pullBack, 0.0f, 1.0f) * WEAPON_POSE_RETRACT_STEPS;
+
+	BlendPose(m_lean, 2 * WEAPON_POSE_LEAN_STEPS, leanIndex, pos, ang);
+	BlendPose(m_retract, WEAPON_POSE_RETRACT_STEPS, retractIndex, pos, ang);
+}
@@ -0,0 +1,63 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_WEAPON_POSE_H
+#define HAL_WEAPON_POSE_H
+
+#include "mathlib/vector.h"
+
+// Samples per side of the lean, and over the full pull-back
+#define WEAPON_POSE_LEAN_STEPS		32
+#define WEAPON_POSE_RETRACT_STEPS	32
+
+
+class WeaponPose
+{
+public:
+	WeaponPose() : pos(0, 0, 0), ang(0, 0, 0) {};
+
+	Vector	pos;
+	QAngle	ang;
+};
+
+
+// The "Leaning" block of a weapon script, sampled over lean [-1, 1] and
+// pull-back [0, 1] with the easing already applied. The viewmodel can then
+// get its offsets from the eye with a couple of lookups, rather than picking
+// a side and easing each angle every frame.
+class WeaponPoseTable
+{
+public:
+	WeaponPoseTable();
+
+	void	Init(	const Vector &neutralPos,	const QAngle &neutralAng,
+					const Vector &leftPos,		const QAngle &leftAng,
+					const Vector &rightPos,		const QAngle &rightAng,
+					const Vector &retractPos,	const QAngle &retractAng );
+
+	// pos is in eye space (x forward, y right, z up). The lean samples are
+	// rebuilt if the ease differs from the one they were built with.
+	void	Lookup(float lean, float pullBack, float ease, Vector &pos, QAngle &ang) const;
+
+private:
+	void	BuildLean(float ease) const;
+
+	Vector	m_neutralPos,	m_leftPos,	m_rightPos;
+	QAngle	m_neutralAng,	m_leftAng,	m_rightAng;
+
+	mutable float		m_ease;
+	mutable WeaponPose	m_lean[2 * WEAPON_POSE_LEAN_STEPS + 1];
+	WeaponPose			m_retract[WEAPON_POSE_RETRACT_STEPS + 1];
+};
+
+#endif
@@ -0,0 +1,173 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+#include "cbase.h"
+#include <KeyValues.h>
+#include "filesystem.h"
+#include "tier0/icommandline.h"
+
+#include "hal/weapon_script_cache.h"
+
+// The client and server both load the scripts, so they keep their own caches.
+// These are generated, so they are kept out of the mod's own folders
+#define WEAPON_SCRIPT_CACHE_DIR		"cache"
+#ifdef CLIENT_DLL
+#define WEAPON_SCRIPT_CACHE_FILE	WEAPON_SCRIPT_CACHE_DIR "/weapon_scripts_client.bin"
+#else
+#define WEAPON_SCRIPT_CACHE_FILE	WEAPON_SCRIPT_CACHE_DIR "/weapon_scripts_server.bin"
+#endif
+
+#define WEAPON_SCRIPT_CACHE_PATH	"MOD"
+
+
+void WeaponScriptCache::Load(IFileSystem *filesystem)
+{
+	m_entries.RemoveAll();
+	m_data.Purge();
+	m_dirty = false;
+
+	if(CommandLine()->FindParm("-noweaponcache"))
+		return;
+
+	CUtlBuffer file;
+	if(!filesystem->ReadFile(WEAPON_SCRIPT_CACHE_FILE, WEAPON_SCRIPT_CACHE_PATH, file))
+		return;
+
+	if(file.GetInt() != WEAPON_SCRIPT_CACHE_ID || file.GetInt() != WEAPON_SCRIPT_CACHE_VERSION)
+	{
+		DevMsg("Ignoring the out of date %s\n", WEAPON_SCRIPT_CACHE_FILE);
+		m_dirty = true;
+		return;
+	}
+
+	int count = file.GetInt();
+	for(int i = 0; i < count && file.IsValid(); i++)
+	{
+		char name[MAX_PATH];
+		file.GetString(name, sizeof(name));
+
+		WeaponScriptEntry entry;
+		entry.scriptCRC	= file.GetUnsignedInt();
+		entry.crc		= file.GetUnsignedInt();
+		entry.length	= file.GetInt();
+
+		if(!file.IsValid() || entry.length < 0 || entry.length > file.GetBytesRemaining())
+			break;
+
+		entry.offset = m_data.TellPut();
+		m_data.Put(file.PeekGet(), entry.length);
+		file.SeekGet(CUtlBuffer::SEEK_CURRENT, entry.length);
+
+		// a damaged entry is simply parsed again
+		if(CRC32_ProcessSingleBuffer((char*)m_data.Base() + entry.offset, entry.length) != entry.crc)
+		{
+			m_dirty = true;
+			continue;
+		}
+
+		m_entries.Insert(name, entry);
+	}
+}
+
+void WeaponScriptCache::Save(IFileSystem *filesystem)
+{
+	if(CommandLine()->FindParm("-noweaponcache"))
+		return;
+
+	// entries for scripts that have gone are dropped
+	int count = 0;
+	for(unsigned short i = m_entries.First(); i != m_entries.InvalidIndex(); i = m_entries.Next(i))
+	{
+		if(m_entries[i].used)
+			count++;
+		else
+			m_dirty = true;
+	}
+
+	if(!m_dirty)
+		return;
+
+	CUtlBuffer file;
+	file.PutInt(WEAPON_SCRIPT_CACHE_ID);
+	file.PutInt(WEAPON_SCRIPT_CACHE_VERSION);
+	file.PutInt(count);
+
+	for(unsigned short i = m_entries.First(); i != m_entries.InvalidIndex(); i = m_entries.Next(i))
+	{
+		const WeaponScriptEntry &entry = m_entries[i];
+		if(!entry.used)
+			continue;
+
+		file.PutString(m_entries.GetElementName(i));
+		file.PutUnsignedInt(entry.scriptCRC);
+		file.PutUnsignedInt(entry.crc);
+		file.PutInt(entry.length);
+		file.Put((char*)m_data.Base() + entry.offset, entry.length);
+	}
+
+	filesystem->CreateDirHierarchy(WEAPON_SCRIPT_CACHE_DIR, WEAPON_SCRIPT_CACHE_PATH);
+	if(!filesystem->WriteFile(WEAPON_SCRIPT_CACHE_FILE, WEAPON_SCRIPT_CACHE_PATH, file))
+		DevMsg("Unable to write %s\n", WEAPON_SCRIPT_CACHE_FILE);
+
+	m_dirty = false;
+}
+
+KeyValues* WeaponScriptCache::Find(const char *scriptName, CRC32_t scriptCRC) const
+{
+	unsigned short i = m_entries.Find(scriptName);
+	if(i == m_entries.InvalidIndex())
+		return NULL;
+
+	const WeaponScriptEntry &entry = m_entries[i];
+	if(entry.scriptCRC != scriptCRC)
+		return NULL;
+
+	CUtlBuffer buffer((char*)m_data.Base() + entry.offset, entry.length, CUtlBuffer::READ_ONLY);
+
+	KeyValues *pKV = new KeyValues("WeaponDatafile");
+	if(!pKV->ReadAsBinary(buffer))
+	{
+		pKV->deleteThis();
+		return NULL;
+	}
+
+	return pKV;
+}
+
+void WeaponScriptCache::MarkUsed(const char *scriptName)
+{
+	unsigned short i = m_entries.Find(scriptName);
+	if(i != m_entries.InvalidIndex())
+		m_entries[i].used = true;
+}
+
+void WeaponScriptCache::Store(const char *scriptName, CRC32_t scriptCRC, KeyValues *pKV)
+{
+	WeaponScriptEntry entry;
+	entry.scriptCRC	= scriptCRC;
+	entry.offset	= m_data.TellPut();
+	if(!pKV->WriteAsBinary(m_data))
+		return;
+
+	entry.length	= m_data.TellPut() - entry.offset;
+	entry.crc		= CRC32_ProcessSingleBuffer((char*)m_data.Base() + entry.offset, entry.length);
+	entry.used		= true;
+
+	unsigned short i = m_entries.Find(scriptName);
+	if(i == m_entries.InvalidIndex())
+		m_entries.Insert(scriptName, entry);
+	else
+		m_entries[i] = entry;
+
+	m_dirty = true;
+}
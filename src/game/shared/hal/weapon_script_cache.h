@@ -0,0 +1,69 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+#ifndef HAL_WEAPON_SCRIPT_CACHE_H
+#define HAL_WEAPON_SCRIPT_CACHE_H
+
+#include "utlbuffer.h"
+#include "utldict.h"
+#include "checksum_crc.h"
+
+class IFileSystem;
+class KeyValues;
+
+// Bump this whenever the layout of the cache file changes
+#define WEAPON_SCRIPT_CACHE_VERSION	2
+#define WEAPON_SCRIPT_CACHE_ID		(('C'<<24)+('S'<<16)+('W'<<8)+'H')
+
+
+class WeaponScriptEntry
+{
+public:
+	WeaponScriptEntry() : scriptCRC(0), offset(0), length(0), crc(0), used(false) {};
+
+	CRC32_t			scriptCRC;	// of the script's text, when it was cached
+	int				offset;		// of the binary KeyValues in the cache's buffer
+	int				length;
+	CRC32_t			crc;
+	bool			used;		// by this load (and so will be saved)
+};
+
+
+// A binary copy of the parsed weapon scripts, so later loads can skip the
+// text parsing. Each entry is checked against a hash of its script's text
+// before use, and anything stale or missing falls back to parsing the text
+// (which then updates the cache).
+class WeaponScriptCache
+{
+public:
+	WeaponScriptCache() : m_dirty(false) {};
+
+	void		Load(IFileSystem *filesystem);
+	void		Save(IFileSystem *filesystem);
+
+	// The caller owns the returned KeyValues. Returns NULL if the cached copy
+	// is missing or was made from different text. This only reads the cache,
+	// so it can be called from several threads at once
+	KeyValues*	Find(const char *scriptName, CRC32_t scriptCRC) const;
+
+	// These are for the main thread, once the scripts have been read
+	void		MarkUsed(const char *scriptName);
+	void		Store(const char *scriptName, CRC32_t scriptCRC, KeyValues *pKV);
+
+private:
+	CUtlDict<WeaponScriptEntry, unsigned short>	m_entries;
+	CUtlBuffer									m_data;
+	bool										m_dirty;
+};
+
+#endif
@@ -16,6 +16,9 @@
 #include "filesystem.h"
 #include "utldict.h"
 #include "ammodef.h"
+#include "hal/weapon_script_cache.h"	// (torbensko)
+#include "vstdlib/jobthread.h"			// (torbensko)
+#include "tier0/icommandline.h"			// (torbensko)
 
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
@@ -80,6 +83,7 @@ extern itemFlags_t g_ItemFlags[7];
 
 
 static CUtlDict< FileWeaponInfo_t*, unsigned short > m_WeaponInfoDatabase;
+static WeaponScriptCache s_WeaponScriptCache;				// (torbensko)
 
 #ifdef _DEBUG
 // used to track whether or not two weapons have been mistakenly assigned the wrong slot
@@ -165,11 +169,122 @@ void ResetFileWeaponInfoDatabase( void )
 }
 #endif
 
+KeyValues* ReadEncryptedKVFile( IFileSystem *filesystem, const char *szFilenameWithoutExtension, const unsigned char *pICEKey );
+
+//-----------------------------------------------------------------------------
+// A weapon script being loaded. Only the file read happens on the thread pool,
+// as the KeyValues tokeniser isn't thread safe (torbensko)
+//-----------------------------------------------------------------------------
+struct WeaponScriptLoad_t
+{
+	char					szName[MAX_WEAPON_STRING];
+	char					szPath[128];
+	const char				*pSearchPath;
+	IFileSystem				*pFileSystem;
+	const unsigned char		*pICEKey;
+	CUtlBuffer				text;
+	KeyValues				*pKV;
+	CRC32_t					scriptCRC;
+	bool					bHasText;		// a plain text script, which can be cached
+	bool					bFromCache;
+};
+
+static void InitWeaponScriptLoad( WeaponScriptLoad_t &load, IFileSystem *filesystem, const unsigned char *pICEKey )
+{
+	Q_snprintf( load.szPath, sizeof( load.szPath ), "scripts/%s", load.szName );
+	load.pSearchPath	= ( pICEKey == NULL ) ? "GAME" : "MOD";
+	load.pFileSystem	= filesystem;
+	load.pICEKey		= pICEKey;
+	load.pKV			= NULL;
+	load.scriptCRC		= 0;
+	load.bHasText		= false;
+	load.bFromCache		= false;
+}
+
+// Reads and hashes the script's text. This must not touch the weapon database,
+// the cache or KeyValues, as it can run on any thread
+static void ReadWeaponScript( WeaponScriptLoad_t &load )
+{
+	char szFullName[MAX_PATH];
+	Q_snprintf( szFullName, sizeof( szFullName ), "%s.txt", load.szPath );
+
+	load.bHasText = load.pFileSystem->ReadFile( szFullName, load.pSearchPath, load.text );
+	if ( !load.bHasText )
+		return;
+
+	load.scriptCRC = CRC32_ProcessSingleBuffer( load.text.Base(), load.text.TellPut() );
+	load.text.PutChar( 0 );
+}
+
+// Tokenises the script, using the binary copy if it was made from the same
+// text. This runs on the main thread
+static void TokeniseWeaponScript( WeaponScriptLoad_t &load )
+{
+	if ( !load.bHasText )
+	{
+		// encrypted (.ctx) scripts aren't cached, rather than writing out their decrypted contents
+		load.pKV = ReadEncryptedKVFile( load.pFileSystem, load.szPath, load.pICEKey );
+		return;
+	}
+
+	load.pKV = s_WeaponScriptCache.Find( load.szPath, load.scriptCRC );
+	load.bFromCache = ( load.pKV != NULL );
+
+	if ( !load.pKV )
+	{
+		char szFullName[MAX_PATH];
+		Q_snprintf( szFullName, sizeof( szFullName ), "%s.txt", load.szPath );
+
+		load.pKV = new KeyValues( "WeaponDatafile" );
+		if ( !load.pKV->LoadFromBuffer( szFullName, (const char*)load.text.Base(), load.pFileSystem ) )
+		{
+			load.pKV->deleteThis();
+			load.pKV = NULL;
+		}
+	}
+
+	load.text.Purge();
+}
+
+// Parses a loaded script into the database, on the main thread
+static bool ParseWeaponScriptForSlot( WeaponScriptLoad_t &load, WEAPON_FILE_INFO_HANDLE *phandle )
+{
+	*phandle = FindWeaponInfoSlot( load.szName );
+	FileWeaponInfo_t *pFileInfo = GetFileWeaponInfoFromHandle( *phandle );
+	Assert( pFileInfo );
+
+	if ( pFileInfo->bParsedScript )
+		return true;
+
+	TokeniseWeaponScript( load );
+	if ( !load.pKV )
+		return false;
+
+	if ( load.bFromCache )
+		s_WeaponScriptCache.MarkUsed( load.szPath );
+	else if ( load.bHasText )
+		s_WeaponScriptCache.Store( load.szPath, load.scriptCRC, load.pKV );
+
+	pFileInfo->Parse( load.pKV, load.szName );
+
+	load.pKV->deleteThis();
+	load.pKV = NULL;
+
+	return true;
+}
+
 void PrecacheFileWeaponInfoDatabase( IFileSystem *filesystem, const unsigned char *pICEKey )
 {
 	if ( m_WeaponInfoDatabase.Count() )
 		return;
 
+	s_WeaponScriptCache.Load( filesystem );					// (torbensko)
+
+	// The scripts are read on the thread pool, then tokenised and parsed into
+	// the database in the manifest's order so the handles don't depend on the
+	// thread timing (torbensko)
+	CUtlVector< WeaponScriptLoad_t > loads;
+
 	KeyValues *manifest = new KeyValues( "weaponscripts" );
 	if ( manifest->LoadFromFile( filesystem, "scripts/weapon_manifest.txt", "GAME" ) )
 	{
@@ -177,17 +292,9 @@ void PrecacheFileWeaponInfoDatabase( IFileSystem *filesystem, const unsigned cha
 		{
 			if ( !Q_stricmp( sub->GetName(), "file" ) )
 			{
-				char fileBase[512];
-				Q_FileBase( sub->GetString(), fileBase, sizeof(fileBase) );
-				WEAPON_FILE_INFO_HANDLE tmp;
-#ifdef CLIENT_DLL
-				if ( ReadWeaponDataFromFileForSlot( filesystem, fileBase, &tmp, pICEKey ) )
-				{
-					gWR.LoadWeaponSprites( tmp );
-				}
-#else
-				ReadWeaponDataFromFileForSlot( filesystem, fileBase, &tmp, pICEKey );
-#endif
+				WeaponScriptLoad_t &load = loads[ loads.AddToTail() ];
+				Q_FileBase( sub->GetString(), load.szName, sizeof(load.szName) );
+				InitWeaponScriptLoad( load, filesystem, pICEKey );
 			}
 			else
 			{
@@ -196,6 +303,31 @@ void PrecacheFileWeaponInfoDatabase( IFileSystem *filesystem, const unsigned cha
 		}
 	}
 	manifest->deleteThis();
+
+	if ( loads.Count() > 1 && !CommandLine()->FindParm( "-noweaponthreads" ) )
+	{
+		ParallelProcess( loads.Base(), loads.Count(), &ReadWeaponScript );
+	}
+	else
+	{
+		for ( int i = 0; i < loads.Count(); i++ )
+			ReadWeaponScript( loads[i] );
+	}
+
+	for ( int i = 0; i < loads.Count(); i++ )
+	{
+		WEAPON_FILE_INFO_HANDLE tmp;
+#ifdef CLIENT_DLL
+		if ( ParseWeaponScriptForSlot( loads[i], &tmp ) )
+		{
+			gWR.LoadWeaponSprites( tmp );
+		}
+#else
+		ParseWeaponScriptForSlot( loads[i], &tmp );
+#endif
+	}
+
+	s_WeaponScriptCache.Save( filesystem );					// (torbensko)
 }
 
 KeyValues* ReadEncryptedKVFile( IFileSystem *filesystem, const char *szFilenameWithoutExtension, const unsigned char *pICEKey )
@@ -280,24 +412,20 @@ bool ReadWeaponDataFromFileForSlot( IFileSystem* filesystem, const char *szWeapo
 		return false;
 	}
 	
-	*phandle = FindWeaponInfoSlot( szWeaponName );
-	FileWeaponInfo_t *pFileInfo = GetFileWeaponInfoFromHandle( *phandle );
-	Assert( pFileInfo );
-
-	if ( pFileInfo->bParsedScript )
+	// Don't bother reading the script if it has already been parsed (torbensko)
+	WEAPON_FILE_INFO_HANDLE handle = LookupWeaponInfoSlot( szWeaponName );
+	if ( handle != GetInvalidWeaponInfoHandle() && GetFileWeaponInfoFromHandle( handle )->bParsedScript )
+	{
+		*phandle = handle;
 		return true;
+	}
 
-	char sz[128];
-	Q_snprintf( sz, sizeof( sz ), "scripts/%s", szWeaponName );
-	KeyValues *pKV = ReadEncryptedKVFile( filesystem, sz, pICEKey );
-	if ( !pKV )
-		return false;
-
-	pFileInfo->Parse( pKV, szWeaponName );
-
-	pKV->deleteThis();
+	WeaponScriptLoad_t load;
+	Q_strncpy( load.szName, szWeaponName, sizeof( load.szName ) );
+	InitWeaponScriptLoad( load, filesystem, pICEKey );
+	ReadWeaponScript( load );
 
-	return true;
+	return ParseWeaponScriptForSlot( load, phandle );
 }
 
 
@@ -502,6 +630,13 @@ void FileWeaponInfo_t::Parse( KeyValues *pKeyValuesData, const char *szWeaponNam
 		leanLeftAngOffset.Init();
 		leanRightPosOffset = vec3_origin;
 		leanRightAngOffset.Init();
+		retractPosOffset = vec3_origin;
+		retractAngOffset.Init();
 	}
+
+	leanPoses.Init(	neutralPosOffset,	neutralAngOffset,
+					leanLeftPosOffset,	leanLeftAngOffset,
+					leanRightPosOffset,	leanRightAngOffset,
+					retractPosOffset,	retractAngOffset );
 }
 
@@ -17,6 +17,7 @@
 #endif
 
 #include "shareddefs.h"
+#include "hal/weapon_pose.h"		// (torbensko)
 
 class IFileSystem;
 
@@ -144,6 +145,9 @@ public:
 	Vector		retractPosOffset;
 	QAngle		retractAngOffset;
 
+	// The above, precompiled for the viewmodel (torbensko)
+	WeaponPoseTable	leanPoses;
+
 };
 
 // The weapon parse function
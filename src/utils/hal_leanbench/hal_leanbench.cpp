@@ -0,0 +1,414 @@
+/*
+
+This code is provided under a Creative Commons Attribution license
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND,
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE.
+
+*/
+
+// Runs the lean solver (lean_solver.h) against procedurally generated
+// geometry, without the need for a map or the game. It reports the trace
+// count, the time per lean and how often the invariants were broken (ending
+// in solid, or not returning to the origin once the lean is back at 0).
+//
+//	hal_leanbench [-sequences 100000] [-seed 1]
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "hal/lean_solver.h"
+#include "hal/util.h"
+
+#ifndef min
+#define min(a,b)	(((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a,b)	(((a) > (b)) ? (a) : (b))
+#endif
+
+#define BENCH_DEFAULT_SEQUENCES		100000
+#define BENCH_LEAN_STEPS			32		// leaning about, per sequence
+#define BENCH_RETURN_STEPS			8		// easing back to 0, per sequence
+#define BENCH_MAX_LEAN_CHANGE		0.15f	// per step
+#define BENCH_TRACE_EPSILON			0.03125f
+#define BENCH_RETURN_TOLERANCE		0.1f
+#define BENCH_MAX_REPORTS			5
+#define BENCH_MAX_BOXES				4
+
+#define BENCH_SCENE_CORRIDOR		0
+#define BENCH_SCENE_SLOPE			1
+#define BENCH_SCENE_STEP			2
+#define BENCH_SCENE_CORNER			3
+#define BENCH_SCENES				4
+
+static const char *s_sceneNames[BENCH_SCENES] = { "corridor", "slope", "step", "corner" };
+
+
+static const char* FindArg(int argc, char **argv, const char *name, const char *defaultValue)
+{
+	for(int i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], name))
+			return (i + 1 < argc && argv[i + 1][0] != '-') ? argv[i + 1] : "";
+	}
+	return defaultValue;
+}
+
+static int FindInt(int argc, char **argv, const char *name, int defaultValue)
+{
+	const char *value = FindArg(argc, argv, name, NULL);
+	return (value && *value) ? atoi(value) : defaultValue;
+}
+
+static double Now()
+{
+	LARGE_INTEGER count, frequency;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return (double)count.QuadPart / (double)frequency.QuadPart;
+}
+
+
+// xorshift, so the scenes don't depend on the runtime's rand()
+class BenchRandom
+{
+public:
+	BenchRandom(unsigned int seed) : m_state(seed ? seed : 1) {}
+
+	float RandomFloat(float low, float high)
+	{
+		m_state ^= m_state << 13;
+		m_state ^= m_state >> 17;
+		m_state ^= m_state << 5;
+		return low + (high - low) * ((m_state >> 8) * (1.0f / 16777216.0f));
+	}
+
+	int RandomInt(int low, int high)
+	{
+		return min(high, low + (int)RandomFloat(0, (float)(high - low + 1)));
+	}
+
+private:
+	unsigned int m_state;
+};
+
+
+class BenchBox
+{
+public:
+	Vector mins;
+	Vector maxs;
+};
+
+
+// Axis aligned boxes, plus an optional ground plane (solid underneath)
+class SyntheticLeanWorld : public ILeanWorld
+{
+public:
+	SyntheticLeanWorld() : m_traces(0) { Clear(); }
+
+	void Clear()
+	{
+		m_boxCount	= 0;
+		m_hasGround	= false;
+	}
+
+	void AddBox(const Vector &mins, const Vector &maxs)
+	{
+		if(m_boxCount == BENCH_MAX_BOXES)
+			return;
+
+		m_boxes[m_boxCount].mins = mins;
+		m_boxes[m_boxCount].maxs = maxs;
+		m_boxCount++;
+	}
+
+	void SetGround(const Vector &normal, float dist)
+	{
+		m_hasGround		= true;
+		m_groundNormal	= normal;
+		m_groundDist	= dist;
+	}
+
+	float TraceHull(const Vector &start, const Vector &end, const Vector &hullMin, const Vector &hullMax);
+	bool IsSolid(const Vector &origin, const Vector &hullMin, const Vector &hullMax);
+
+	// How far the hull is above the ground (negative when in it)
+	float GroundDistance(const Vector &origin, const Vector &hullMin, const Vector &hullMax);
+
+	int m_traces;
+
+private:
+	BenchBox	m_boxes[BENCH_MAX_BOXES];
+	int			m_boxCount;
+
+	bool	m_hasGround;
+	Vector	m_groundNormal;
+	float	m_groundDist;
+};
+
+float SyntheticLeanWorld::GroundDistance(const Vector &origin, const Vector &hullMin, const Vector &hullMax)
+{
+	// the corner of the hull furthest into the ground
+	Vector corner(
+			(m_groundNormal.x > 0) ? hullMin.x : hullMax.x,
+			(m_groundNormal.y > 0) ? hullMin.y : hullMax.y,
+			(m_groundNormal.z > 0) ? hullMin.z : hullMax.z);
+
+	return DotProduct(m_groundNormal, origin + corner) - m_groundDist;
+}
+
+float SyntheticLeanWorld::TraceHull(const Vector &start, const Vector &end, const Vector &hullMin, const Vector &hullMax)
+{
+	m_traces++;
+
+	Vector delta = end - start;
+	float length = delta.Length();
+	if(length == 0.0f)
+		return IsSolid(start, hullMin, hullMax) ? 0.0f : 1.0f;
+
+	float epsilon = BENCH_TRACE_EPSILON / length;
+	float fraction = 1.0f;
+
+	if(m_hasGround)
+	{
+		float startDist = GroundDistance(start, hullMin, hullMax);
+		float endDist	= GroundDistance(end, hullMin, hullMax);
+
+		if(startDist < 0.0f)
+			return 0.0f;
+
+		if(endDist < 0.0f)
+			fraction = min(fraction, max(0.0f, startDist / (startDist - endDist) - epsilon));
+	}
+
+	// Each box is grown by the hull, so we only need to trace a ray against it
+	for(int i = 0; i < m_boxCount; i++)
+	{
+		Vector mins = m_boxes[i].mins - hullMax;
+		Vector maxs = m_boxes[i].maxs - hullMin;
+
+		float enter = -1.0f;
+		float leave = 2.0f;
+		bool missed = false;
+
+		for(int axis = 0; axis < 3 && !missed; axis++)
+		{
+			if(delta[axis] == 0.0f)
+			{
+				missed = (start[axis] <= mins[axis] || start[axis] >= maxs[axis]);
+				continue;
+			}
+
+			float t1 = (mins[axis] - start[axis]) / delta[axis];
+			float t2 = (maxs[axis] - start[axis]) / delta[axis];
+			enter = max(enter, min(t1, t2));
+			leave = min(leave, max(t1, t2));
+			missed = (enter >= leave);
+		}
+
+		if(missed || leave <= 0.0f || enter >= 1.0f)
+			continue;
+
+		// starting inside the box
+		if(enter < 0.0f)
+			return 0.0f;
+
+		fraction = min(fraction, max(0.0f, enter - epsilon));
+	}
+
+	return fraction;
+}
+
+bool SyntheticLeanWorld::IsSolid(const Vector &origin, const Vector &hullMin, const Vector &hullMax)
+{
+	if(m_hasGround && GroundDistance(origin, hullMin, hullMax) < 0.0f)
+		return true;
+
+	for(int i = 0; i < m_boxCount; i++)
+	{
+		Vector mins = m_boxes[i].mins - hullMax;
+		Vector maxs = m_boxes[i].maxs - hullMin;
+
+		if(	origin.x > mins.x && origin.x < maxs.x &&
+			origin.y > mins.y && origin.y < maxs.y &&
+			origin.z > mins.z && origin.z < maxs.z)
+			return true;
+	}
+	return false;
+}
+
+
+// Builds one of the scenes around the origin, with the player placed so that
+// they stand on the ground. Returns the starting position of the player.
+static Vector BuildScene(SyntheticLeanWorld &world, int scene, BenchRandom &random)
+{
+	Vector origin(0, 0, 0);
+	float ground = 0.0f;
+
+	world.Clear();
+
+	switch(scene)
+	{
+	case BENCH_SCENE_CORRIDOR:
+		{
+			// walls either side, anywhere from touching to out of reach
+			float left	= LEAN_PLAYER_SIZE/2 + random.RandomFloat(0, 80);
+			float right = LEAN_PLAYER_SIZE/2 + random.RandomFloat(0, 80);
+			world.AddBox(Vector(-512, -512, -64), Vector(512, 512, ground));
+			world.AddBox(Vector(-512,  left, ground), Vector(512,  left + 16, 128));
+			world.AddBox(Vector(-512, -right - 16, ground), Vector(512, -right, 128));
+		}
+		break;
+
+	case BENCH_SCENE_SLOPE:
+		{
+			// a ramp rising (or falling) in a random direction, up to 45 degrees
+			float pitch = DEG_TO_RAD(random.RandomFloat(0, 45));
+			float dir	= DEG_TO_RAD(random.RandomFloat(0, 360));
+			Vector normal(-sin(pitch) * cos(dir), -sin(pitch) * sin(dir), cos(pitch));
+			world.SetGround(normal, 0);
+
+			// stand on it
+			origin.z -= world.GroundDistance(origin, LeanSolver::HullMin(), LeanSolver::HullMax()) / normal.z;
+			origin.z += BENCH_TRACE_EPSILON;
+		}
+		break;
+
+	case BENCH_SCENE_STEP:
+		{
+			// a step up (or down) beside the player
+			float height	= random.RandomFloat(-24, 24);
+			float distance	= LEAN_PLAYER_SIZE/2 + random.RandomFloat(0, 48);
+			float side		= (random.RandomInt(0, 1) == 0) ? 1.0f : -1.0f;
+
+			world.AddBox(Vector(-512, -512, -64), Vector(512, 512, min(ground, height)));
+			if(side > 0)
+				world.AddBox(Vector(-512, distance, -64), Vector(512, 512, max(ground, height)));
+			else
+				world.AddBox(Vector(-512, -512, -64), Vector(512, -distance, max(ground, height)));
+
+			if(height < 0.0f)
+				origin.z = height; // the player is on the lower side
+		}
+		break;
+
+	case BENCH_SCENE_CORNER:
+		{
+			// a wall beside the player that ends a short way in front of them
+			float distance	= LEAN_PLAYER_SIZE/2 + random.RandomFloat(0, 32);
+			float end		= random.RandomFloat(-LEAN_PLAYER_SIZE, LEAN_PLAYER_SIZE);
+			float side		= (random.RandomInt(0, 1) == 0) ? 1.0f : -1.0f;
+
+			world.AddBox(Vector(-512, -512, -64), Vector(512, 512, ground));
+			if(side > 0)
+				world.AddBox(Vector(-512, distance, ground), Vector(end, distance + 16, 128));
+			else
+				world.AddBox(Vector(-512, -distance - 16, ground), Vector(end, -distance, 128));
+		}
+		break;
+	}
+
+	return origin;
+}
+
+
+int main(int argc, char **argv)
+{
+	int sequences	= FindInt(argc, argv, "-sequences", BENCH_DEFAULT_SEQUENCES);
+	int seed		= FindInt(argc, argv, "-seed", 1);
+
+	BenchRandom random(seed);
+
+	SyntheticLeanWorld world;
+	Vector hullMin = LeanSolver::HullMin();
+	Vector hullMax = LeanSolver::HullMax();
+
+	int leans = 0;
+	int inSolid[BENCH_SCENES] = { 0 };
+	int notReturned[BENCH_SCENES] = { 0 };
+	int runs[BENCH_SCENES] = { 0 };
+	int reports = 0;
+	float maxDrift = 0.0f;
+
+	double start = Now();
+
+	for(int s = 0; s < sequences; s++)
+	{
+		int scene = random.RandomInt(0, BENCH_SCENES - 1);
+		Vector origin = BuildScene(world, scene, random);
+		Vector startOrigin = origin;
+		runs[scene]++;
+
+		float yaw = DEG_TO_RAD(random.RandomFloat(0, 360));
+		Vector right(sin(yaw), -cos(yaw), 0);
+
+		LeanState state;
+		float lean = 0.0f;
+		float target = 0.0f;
+		bool solid = false;
+
+		for(int step = 0; step < BENCH_LEAN_STEPS + BENCH_RETURN_STEPS + 1; step++)
+		{
+			if(step < BENCH_LEAN_STEPS)
+			{
+				if(fabs(target - lean) < 0.01f)
+					target = random.RandomFloat(-1, 1);
+				lean += max(-BENCH_MAX_LEAN_CHANGE, min(BENCH_MAX_LEAN_CHANGE, target - lean));
+			}
+			else
+			{
+				lean -= lean / (BENCH_LEAN_STEPS + BENCH_RETURN_STEPS - step + 1);
+			}
+
+			leans++;
+			float movementAmount = LeanSolver::Prepare(state, lean);
+			if(movementAmount == 0.0f)
+				continue;
+
+			float fraction;
+			Vector offset;
+			LeanSolver::Resolve(&world, origin, right, movementAmount, fraction, offset);
+			LeanSolver::Apply(state, movementAmount, fraction);
+			origin += offset;
+
+			solid |= world.IsSolid(origin, hullMin, hullMax);
+		}
+
+		Vector drift = origin - startOrigin;
+		float horDrift = drift.Length2D();
+		maxDrift = max(maxDrift, horDrift);
+
+		if(solid)
+			inSolid[scene]++;
+		if(horDrift > BENCH_RETURN_TOLERANCE)
+			notReturned[scene]++;
+
+		if((solid || horDrift > BENCH_RETURN_TOLERANCE) && reports++ < BENCH_MAX_REPORTS)
+			printf("  sequence %d (%s): %s, drift %.3f %.3f %.3f\n", s, s_sceneNames[scene],
+					(solid) ? "ended in solid" : "did not return", drift.x, drift.y, drift.z);
+	}
+
+	double elapsed = Now() - start;
+
+	printf("%d sequences, %d leans, %d traces in %.3f s (seed %d)\n", sequences, leans, world.m_traces, elapsed, seed);
+	printf("  %.1f ns per lean, %.2f traces per lean, max horizontal drift %.3f\n",
+			(leans > 0) ? elapsed * 1e9 / leans : 0, (leans > 0) ? world.m_traces / (float)leans : 0, maxDrift);
+
+	int failures = 0;
+	for(int i = 0; i < BENCH_SCENES; i++)
+	{
+		printf("  %-10s %8d runs, %6d in solid, %6d not returned\n", s_sceneNames[i], runs[i], inSolid[i], notReturned[i]);
+		failures += inSolid[i] + notReturned[i];
+	}
+
+	return (failures > 0) ? 1 : 0;
+}
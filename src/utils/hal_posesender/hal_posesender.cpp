@@ -0,0 +1,171 @@
+/*
+
+This code is provided under a Creative Commons Attribution license 
+http://creativecommons.org/licenses/by/3.0/
+As such you are free to use the code for any purpose as long as you remember 
+to mention my name (Torben Sko) at some point.
+
+Please also note that my code is provided AS IS with NO WARRANTY OF ANY KIND, 
+INCLUDING THE WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE.
+
+*/
+
+// A small test program that generates head motion (see synthetic_motion.h)
+// and sends it to the game, either over UDP (for the "udp" tracker) or
+// through shared memory (for the "shm" tracker). It can also write it to a
+// recording for the "replay" tracker instead.
+//
+//	hal_posesender [-shm] [-port 4242] [-speed 1] [-seconds 0]
+//	               [-write file.csv] [-seed 1] [-rate 30] [-leans 6] [-nods 4]
+//	               [-jitter 0.3] [-collapses 1] [-dropouts 1]
+//
+// -speed plays the motion faster than real time, and -seconds 0 runs until
+// the program is closed. The same seed and settings always give the same
+// motion.
+
+#include <winsock2.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../game/shared/hal/shm_tracker.h"
+#include "../../game/shared/hal/synthetic_motion.h"
+
+#define DEFAULT_PORT	4242
+
+static const char* FindArg(int argc, char **argv, const char *name, const char *defaultValue)
+{
+	for(int i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], name))
+			return (i + 1 < argc && argv[i + 1][0] != '-') ? argv[i + 1] : "";
+	}
+	return defaultValue;
+}
+
+static float FindFloat(int argc, char **argv, const char *name, float defaultValue)
+{
+	const char *value = FindArg(argc, argv, name, NULL);
+	return (value && *value) ? (float)atof(value) : defaultValue;
+}
+
+// In the same columns as the game's hal_synthWrite
+static int WriteRecording(const char *fileName, SyntheticMotion &motion, double seconds)
+{
+	FILE *f = fopen(fileName, "w");
+	if(!f)
+	{
+		printf("Unable to write %s\n", fileName);
+		return 1;
+	}
+
+	fprintf(f, "time,confidence,raw_roll,raw_pitch,raw_yaw,raw_vert,raw_sidew,raw_depth\n");
+
+	int count = 0;
+	SyntheticSample sample;
+	for(motion.Next(sample); sample.time <= seconds; motion.Next(sample))
+	{
+		fprintf(f, "%.4f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", sample.time, sample.confidence,
+				sample.pose[HEADPOSE_ROLL], sample.pose[HEADPOSE_PITCH], sample.pose[HEADPOSE_YAW],
+				sample.pose[HEADPOSE_Y], -sample.pose[HEADPOSE_X], sample.pose[HEADPOSE_Z]);
+		count++;
+	}
+
+	fclose(f);
+	printf("Wrote %d samples to %s\n", count, fileName);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	SyntheticMotionSettings settings;
+	settings.seed				= (unsigned int)FindFloat(argc, argv, "-seed", (float)settings.seed);
+	settings.frameRate			= FindFloat(argc, argv, "-rate", settings.frameRate);
+	settings.leansPerMinute		= FindFloat(argc, argv, "-leans", settings.leansPerMinute);
+	settings.nodsPerMinute		= FindFloat(argc, argv, "-nods", settings.nodsPerMinute);
+	settings.jitter				= FindFloat(argc, argv, "-jitter", settings.jitter);
+	settings.collapsesPerMinute	= FindFloat(argc, argv, "-collapses", settings.collapsesPerMinute);
+	settings.dropoutsPerMinute	= FindFloat(argc, argv, "-dropouts", settings.dropoutsPerMinute);
+
+	if(settings.frameRate <= 0)
+		settings.frameRate = SyntheticMotionSettings().frameRate;
+
+	SyntheticMotion motion;
+	motion.Reset(settings);
+
+	bool useShm		= FindArg(argc, argv, "-shm", NULL) != NULL;
+	int port		= (int)FindFloat(argc, argv, "-port", DEFAULT_PORT);
+	double speed	= FindFloat(argc, argv, "-speed", 1);
+	double seconds	= FindFloat(argc, argv, "-seconds", 0);
+
+	const char *recording = FindArg(argc, argv, "-write", NULL);
+	if(recording)
+		return WriteRecording(recording, motion, (seconds > 0) ? seconds : 60);
+
+	if(speed <= 0)
+		speed = 1;
+
+	SOCKET sock = INVALID_SOCKET;
+	sockaddr_in address;
+	HeadPoseRingWriter writer;
+
+	if(useShm)
+	{
+		if(!writer.Open((float)(settings.frameRate * speed)))
+		{
+			printf("Unable to open %s (error %d)\n", HEADPOSE_SHM_NAME, GetLastError());
+			return 1;
+		}
+		printf("Writing to %s at %gx\n", HEADPOSE_SHM_NAME, speed);
+	}
+	else
+	{
+		WSADATA wsaData;
+		WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+		memset(&address, 0, sizeof(address));
+		address.sin_family		= AF_INET;
+		address.sin_port		= htons((u_short)port);
+		address.sin_addr.s_addr	= htonl(INADDR_LOOPBACK);
+
+		sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if(sock == INVALID_SOCKET)
+		{
+			printf("Unable to create a socket (error %d)\n", WSAGetLastError());
+			return 1;
+		}
+		printf("Sending to port %d at %gx\n", port, speed);
+	}
+
+	// run to the motion's own schedule, so a slow send doesn't change it
+	timeBeginPeriod(1);
+	double start = HeadPoseTimestamp();
+
+	SyntheticSample sample;
+	for(motion.Next(sample); seconds <= 0 || sample.time <= seconds; motion.Next(sample))
+	{
+		double due = start + sample.time / speed;
+		double wait = due - HeadPoseTimestamp();
+		if(wait > 0)
+			Sleep((DWORD)(wait * 1000));
+
+		if(useShm)
+		{
+			writer.Write(sample.pose, sample.confidence, due);
+		}
+		else if(sample.confidence > 0)
+		{
+			// the packets have no confidence, so a dropout just stops them
+			sendto(sock, (const char*)sample.pose, sizeof(sample.pose), 0, (sockaddr*)&address, sizeof(address));
+		}
+	}
+	timeEndPeriod(1);
+
+	if(sock != INVALID_SOCKET)
+	{
+		closesocket(sock);
+		WSACleanup();
+	}
+	return 0;
+}